@@ -0,0 +1,1235 @@
+/*
+ * bddcheck.c - Prove that a solution in bits.c is correct, with BDDs
+ *
+ * btest -P uses these routines to compare a solution with its test
+ * function on every input, rather than on samples. The solution is
+ * parsed from the source in bits.c and "run" on vectors of binary
+ * decision diagrams (BDDs), one for each bit of a value, over the
+ * bits of the arguments. This gives the BDD of each bit of its
+ * result. The test functions in tests.c use switches, loops, and long
+ * longs, so each one has a specification in the same language instead
+ * (see specs below), which is run the same way. The two are equal on
+ * every input exactly when each bit has the same BDD in both, and
+ * otherwise any path to the 1 leaf of the BDD of their difference is
+ * an input where they differ.
+ *
+ * The language is the straight-line C that dlc allows in the integer
+ * puzzles: int and unsigned variables and constants, the operators
+ * other than * / and %, assignments, and return. For loops and ifs
+ * are allowed if their conditions don't depend on the arguments (the
+ * specifications use them). The float puzzles branch on their
+ * arguments, so they can't be checked. Signed overflow wraps around
+ * and shift amounts are taken mod 32, as on x86. The compiled code
+ * need not agree (e.g. gcc may assume that x + 1 > x), so both the
+ * solution and the specification are also run on a few thousand
+ * inputs and compared with the compiled code first, and a difference
+ * in the BDDs is only reported once the compiled code confirms it.
+ *
+ * The bits of the arguments are interleaved in the variable order,
+ * from the least significant up, which keeps the BDDs of sums and
+ * comparisons small.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <setjmp.h>
+
+#include "btest.h"
+#include "bddcheck.h"
+
+/* Give up on a function once there are this many BDD nodes (a power
+   of 2, since it is also the size of the hash table) */
+#define MAX_NODES (1 << 21)
+
+/* Entries in the cache of ITE results (a power of 2) */
+#define CACHE_SIZE (1 << 18)
+
+/* The solution and the specification are run on this many inputs,
+   and compared with the compiled code, before the proof */
+#define CHECK_INPUTS 4096
+
+/* Most iterations of a for loop, and most variables in a function */
+#define MAX_ITERS 1024
+#define MAX_VARS  64
+
+/*************
+ * BDD package
+ *************/
+
+/* A BDD is the index of its root node. Bit i of argument k is
+   variable BIT_VAR(k, i), and the leaves have variable NUM_VARS. */
+typedef int bdd_t;
+#define BDD_0 0
+#define BDD_1 1
+#define NUM_VARS 96
+#define BIT_VAR(k, i) (3 * (i) + (k))
+
+typedef struct {
+    int var;          /* variable tested at this node */
+    bdd_t lo, hi;     /* the BDDs when it is 0 and when it is 1 */
+    bdd_t next;       /* next node in the same hash bucket, or -1 */
+} node_t;
+
+static node_t *nodes = NULL;
+static int num_nodes = 0;
+static bdd_t *buckets = NULL;       /* MAX_NODES hash chains */
+static struct {
+    bdd_t f, g, h, r;               /* ite(f, g, h) is r */
+} *cache = NULL;
+
+/* Where to go, and what to say, when a function can't be checked */
+static jmp_buf check_env;
+static char *check_why;
+static int check_whylen;
+
+static void check_error(char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(check_why, check_whylen, fmt, ap);
+    va_end(ap);
+    longjmp(check_env, 1);
+}
+
+/*
+ * bdd_reset - Free all the BDD nodes except the leaves
+ */
+static void bdd_reset(void)
+{
+    if (nodes == NULL) {
+	nodes = malloc(MAX_NODES * sizeof(node_t));
+	buckets = malloc(MAX_NODES * sizeof(bdd_t));
+	cache = malloc(CACHE_SIZE * sizeof(*cache));
+	if (nodes == NULL || buckets == NULL || cache == NULL) {
+	    printf("Out of memory\n");
+	    exit(1);
+	}
+    }
+    memset(buckets, 0xff, MAX_NODES * sizeof(bdd_t));
+    memset(cache, 0xff, CACHE_SIZE * sizeof(*cache));
+    nodes[BDD_0].var = nodes[BDD_1].var = NUM_VARS;
+    nodes[BDD_0].lo = nodes[BDD_0].hi = BDD_0;
+    nodes[BDD_1].lo = nodes[BDD_1].hi = BDD_1;
+    num_nodes = 2;
+}
+
+/*
+ * bdd_node - Return the node that tests var, with children lo and hi
+ */
+static bdd_t bdd_node(int var, bdd_t lo, bdd_t hi)
+{
+    unsigned h;
+    bdd_t f;
+
+    if (lo == hi)
+	return lo;
+    h = ((unsigned) var * 12582917u + (unsigned) lo * 4256249u +
+	 (unsigned) hi * 741457u) & (MAX_NODES - 1);
+    for (f = buckets[h]; f >= 0; f = nodes[f].next)
+	if (nodes[f].var == var && nodes[f].lo == lo && nodes[f].hi == hi)
+	    return f;
+    if (num_nodes == MAX_NODES)
+	check_error("its BDDs need more than %d nodes", MAX_NODES);
+    f = num_nodes++;
+    nodes[f].var = var;
+    nodes[f].lo = lo;
+    nodes[f].hi = hi;
+    nodes[f].next = buckets[h];
+    buckets[h] = f;
+    return f;
+}
+
+/*
+ * bdd_ite - Return the BDD of "if f then g else h"
+ */
+static bdd_t bdd_ite(bdd_t f, bdd_t g, bdd_t h)
+{
+    unsigned c;
+    int v;
+    bdd_t lo, hi;
+
+    if (f == BDD_1 || g == h)
+	return g;
+    if (f == BDD_0)
+	return h;
+    if (g == BDD_1 && h == BDD_0)
+	return f;
+
+    c = ((unsigned) f * 0x9e3779b1u ^ (unsigned) g * 0x85ebca6bu ^
+	 (unsigned) h * 0xc2b2ae35u) & (CACHE_SIZE - 1);
+    if (cache[c].f == f && cache[c].g == g && cache[c].h == h)
+	return cache[c].r;
+
+    v = nodes[f].var;
+    if (nodes[g].var < v)
+	v = nodes[g].var;
+    if (nodes[h].var < v)
+	v = nodes[h].var;
+    lo = bdd_ite(nodes[f].var == v ? nodes[f].lo : f,
+		 nodes[g].var == v ? nodes[g].lo : g,
+		 nodes[h].var == v ? nodes[h].lo : h);
+    hi = bdd_ite(nodes[f].var == v ? nodes[f].hi : f,
+		 nodes[g].var == v ? nodes[g].hi : g,
+		 nodes[h].var == v ? nodes[h].hi : h);
+
+    cache[c].f = f;
+    cache[c].g = g;
+    cache[c].h = h;
+    return cache[c].r = bdd_node(v, lo, hi);
+}
+
+#define bdd_not(f)    bdd_ite(f, BDD_0, BDD_1)
+#define bdd_and(f, g) bdd_ite(f, g, BDD_0)
+#define bdd_or(f, g)  bdd_ite(f, BDD_1, g)
+#define bdd_xor(f, g) bdd_ite(f, bdd_not(g), g)
+
+/*
+ * bdd_eval - Return the value of f for the arguments in args
+ */
+static int bdd_eval(bdd_t f, int *args)
+{
+    int v;
+
+    while (f != BDD_0 && f != BDD_1) {
+	v = nodes[f].var;
+	f = ((unsigned) args[v % 3] >> (v / 3)) & 1 ? nodes[f].hi : nodes[f].lo;
+    }
+    return f;
+}
+
+/*
+ * bdd_witness - Put arguments for which f, which isn't BDD_0, is 1
+ *    in args
+ */
+static void bdd_witness(bdd_t f, int *args)
+{
+    int v;
+
+    args[0] = args[1] = args[2] = 0;
+    while (f != BDD_1) {
+	v = nodes[f].var;
+	if (nodes[f].lo != BDD_0)
+	    f = nodes[f].lo;
+	else {
+	    args[v % 3] |= 1u << (v / 3);
+	    f = nodes[f].hi;
+	}
+    }
+}
+
+/*************
+ * Bit vectors
+ *************/
+
+/* A 32-bit C value, with a BDD for each bit */
+typedef struct {
+    bdd_t bit[32];   /* bit[0] is the least significant */
+    int uns;         /* set if it is unsigned */
+} vec_t;
+
+static vec_t vec_const(unsigned u, int uns)
+{
+    vec_t r;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	r.bit[i] = (u >> i) & 1 ? BDD_1 : BDD_0;
+    r.uns = uns;
+    return r;
+}
+
+/*
+ * vec_value - Return true if a doesn't depend on the arguments, and
+ *    if so put its value in *u
+ */
+static int vec_value(vec_t *a, unsigned *u)
+{
+    int i;
+
+    *u = 0;
+    for (i = 0; i < 32; i++) {
+	if (a->bit[i] != BDD_0 && a->bit[i] != BDD_1)
+	    return 0;
+	*u |= (unsigned) a->bit[i] << i;
+    }
+    return 1;
+}
+
+/* vec_nonzero - Return the BDD of a != 0 */
+static bdd_t vec_nonzero(vec_t *a)
+{
+    bdd_t f = BDD_0;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	f = bdd_or(f, a->bit[i]);
+    return f;
+}
+
+/* vec_bool - Return the int that is 1 if f is, and 0 if not */
+static vec_t vec_bool(bdd_t f)
+{
+    vec_t r = vec_const(0, 0);
+
+    r.bit[0] = f;
+    return r;
+}
+
+/* vec_mux - Return c ? a : b */
+static vec_t vec_mux(bdd_t c, vec_t *a, vec_t *b)
+{
+    vec_t r;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	r.bit[i] = bdd_ite(c, a->bit[i], b->bit[i]);
+    r.uns = a->uns || b->uns;
+    return r;
+}
+
+/* vec_add - Return a + b + carry (which is BDD_0 or BDD_1) */
+static vec_t vec_add(vec_t *a, vec_t *b, bdd_t carry)
+{
+    vec_t r;
+    bdd_t half;
+    int i;
+
+    for (i = 0; i < 32; i++) {
+	half = bdd_xor(a->bit[i], b->bit[i]);
+	r.bit[i] = bdd_xor(half, carry);
+	carry = bdd_or(bdd_and(a->bit[i], b->bit[i]), bdd_and(half, carry));
+    }
+    r.uns = a->uns || b->uns;
+    return r;
+}
+
+/* vec_not - Return ~a */
+static vec_t vec_not(vec_t *a)
+{
+    vec_t r;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	r.bit[i] = bdd_not(a->bit[i]);
+    r.uns = a->uns;
+    return r;
+}
+
+/*
+ * vec_shift - Return a << n (if left) or a >> n, with the amount
+ *    taken mod 32. Right shifts of int values copy the sign bit.
+ */
+static vec_t vec_shift(vec_t *a, vec_t *n, int left)
+{
+    vec_t r = *a;
+    bdd_t moved[32];
+    int i, j, from;
+
+    for (j = 0; j < 5; j++) {
+	if (n->bit[j] == BDD_0)
+	    continue;
+	for (i = 0; i < 32; i++) {
+	    from = left ? i - (1 << j) : i + (1 << j);
+	    if (from >= 0 && from < 32)
+		moved[i] = r.bit[from];
+	    else
+		moved[i] = left || a->uns ? BDD_0 : r.bit[31];
+	}
+	for (i = 0; i < 32; i++)
+	    r.bit[i] = bdd_ite(n->bit[j], moved[i], r.bit[i]);
+    }
+    return r;
+}
+
+/* vec_equal - Return the BDD of a == b */
+static bdd_t vec_equal(vec_t *a, vec_t *b)
+{
+    bdd_t f = BDD_1;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	f = bdd_and(f, bdd_not(bdd_xor(a->bit[i], b->bit[i])));
+    return f;
+}
+
+/*
+ * vec_less - Return the BDD of a < b, comparing them as unsigned if
+ *    uns is set. The highest bit where they differ decides.
+ */
+static bdd_t vec_less(vec_t *a, vec_t *b, int uns)
+{
+    bdd_t f = BDD_0;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	f = bdd_ite(bdd_xor(a->bit[i], b->bit[i]),
+		    i == 31 && !uns ? a->bit[i] : b->bit[i], f);
+    return f;
+}
+
+/**********************************
+ * Running functions on bit vectors
+ **********************************/
+
+#define TOK_END   0
+#define TOK_ID    1
+#define TOK_NUM   2
+#define TOK_OP    3
+#define TOK_OTHER 4   /* string and char constants */
+
+typedef struct {
+    int kind;
+    char *s;         /* its text, which is len chars long */
+    int len;
+    unsigned val;    /* the value of a number, */
+    int uns;         /* and whether it is unsigned */
+    int line;
+} token_t;
+
+static token_t *toks = NULL;
+static int num_toks = 0, max_toks = 0;
+static int pos;                /* the next token */
+static char *where;            /* "bits.c", or the specification */
+
+/* Bits of each argument that can be 1: an argument whose range is 0
+   to 2^n - 1 has its higher bits set to 0 */
+static int arg_bits[3];
+
+/* Operators of more than one char, longest first */
+static char *long_ops[] = {
+    "<<=", ">>=", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||",
+    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "++", "--", "->", NULL
+};
+
+static void add_token(int kind, char *s, int len, int line)
+{
+    if (num_toks == max_toks) {
+	max_toks = max_toks ? 2 * max_toks : 1024;
+	toks = realloc(toks, max_toks * sizeof(token_t));
+	if (toks == NULL) {
+	    printf("Out of memory\n");
+	    exit(1);
+	}
+    }
+    toks[num_toks].kind = kind;
+    toks[num_toks].s = s;
+    toks[num_toks].len = len;
+    toks[num_toks].val = 0;
+    toks[num_toks].uns = 0;
+    toks[num_toks++].line = line;
+}
+
+/*
+ * tokenize - Split the C source in src into toks. Comments and
+ *    preprocessor lines are left out, and so is the text between
+ *    #if 0 and its #endif.
+ */
+static void tokenize(char *src)
+{
+    char *p = src, *q;
+    int line = 1, bol = 1, depth, i, n;
+
+    num_toks = 0;
+    while (*p) {
+	if (*p == '\n') {
+	    line++;
+	    bol = 1;
+	    p++;
+	    continue;
+	}
+	if (isspace((unsigned char) *p)) {
+	    p++;
+	    continue;
+	}
+	if (p[0] == '/' && p[1] == '*') {
+	    for (p += 2; *p && !(p[0] == '*' && p[1] == '/'); p++)
+		line += *p == '\n';
+	    p += *p ? 2 : 0;
+	    continue;
+	}
+	if (p[0] == '/' && p[1] == '/') {
+	    while (*p && *p != '\n')
+		p++;
+	    continue;
+	}
+	if (*p == '#' && bol) {
+	    for (q = p + 1; *q == ' ' || *q == '\t'; q++)
+		;
+	    depth = !strncmp(q, "if", 2) &&
+		sscanf(q + 2, " %d", &n) == 1 && n == 0;
+	    /* Skip this line, and the whole block if it is #if 0 */
+	    do {
+		while (*p && *p != '\n') {
+		    if (p[0] == '\\' && p[1] == '\n') {
+			line++;
+			p++;
+		    }
+		    p++;
+		}
+		if (depth == 0 || *p == '\0')
+		    break;
+		line++;
+		p++;
+		for (q = p; *q == ' ' || *q == '\t'; q++)
+		    ;
+		if (*q == '#') {
+		    for (q++; *q == ' ' || *q == '\t'; q++)
+			;
+		    if (!strncmp(q, "if", 2))
+			depth++;
+		    else if (!strncmp(q, "endif", 5))
+			depth--;
+		}
+	    } while (1);
+	    continue;
+	}
+	bol = 0;
+
+	if (isalpha((unsigned char) *p) || *p == '_') {
+	    for (q = p; isalnum((unsigned char) *q) || *q == '_'; q++)
+		;
+	    add_token(TOK_ID, p, q - p, line);
+	    p = q;
+	}
+	else if (isdigit((unsigned char) *p)) {
+	    unsigned long long v = strtoull(p, &q, 0);
+
+	    add_token(TOK_NUM, p, q - p, line);
+	    toks[num_toks - 1].val = v;
+	    toks[num_toks - 1].uns = v > 0x7fffffff;
+	    for (; *q == 'u' || *q == 'U' || *q == 'l' || *q == 'L'; q++)
+		if (*q == 'u' || *q == 'U')
+		    toks[num_toks - 1].uns = 1;
+	    p = q;
+	}
+	else if (*p == '"' || *p == '\'') {
+	    for (q = p + 1; *q && *q != *p && *q != '\n'; q++)
+		q += q[0] == '\\' && q[1];
+	    add_token(TOK_OTHER, p, q - p + (*q == *p), line);
+	    p = q + (*q == *p);
+	}
+	else {
+	    n = 1;
+	    for (i = 0; long_ops[i]; i++)
+		if (!strncmp(p, long_ops[i], strlen(long_ops[i]))) {
+		    n = strlen(long_ops[i]);
+		    break;
+		}
+	    add_token(TOK_OP, p, n, line);
+	    p += n;
+	}
+    }
+    add_token(TOK_END, p, 0, line);
+}
+
+/* The variables in scope, and the result once it is returned */
+static struct {
+    char *name;
+    int len;
+    vec_t val;
+} vars[MAX_VARS];
+static int num_vars;
+static int exec;               /* clear while skipping code */
+static int returned;
+static vec_t result;
+
+/* Give up, saying where in the source */
+#define parse_error(fmt, ...) \
+    check_error("%s, line %d: " fmt, where, toks[pos].line, ##__VA_ARGS__)
+
+static int tok_is(char *s)
+{
+    return toks[pos].kind != TOK_END && toks[pos].len == strlen(s) &&
+	!strncmp(toks[pos].s, s, toks[pos].len);
+}
+
+static int accept(char *s)
+{
+    if (!tok_is(s))
+	return 0;
+    pos++;
+    return 1;
+}
+
+static void expect(char *s)
+{
+    if (!accept(s))
+	parse_error("expected \"%s\" before \"%.*s\"", s, toks[pos].len,
+		    toks[pos].s);
+}
+
+/*
+ * parse_type - Skip the type at pos, if there is one. Return 1 for
+ *    unsigned, 0 for int, and -1 if there is no type there.
+ */
+static int parse_type(void)
+{
+    int uns = -1;
+
+    while (toks[pos].kind == TOK_ID) {
+	if (accept("int") || accept("signed") || accept("const"))
+	    uns = uns < 0 ? 0 : uns;
+	else if (accept("unsigned"))
+	    uns = 1;
+	else if (tok_is("char") || tok_is("short") || tok_is("long") ||
+		 tok_is("float") || tok_is("double"))
+	    parse_error("only int and unsigned values are allowed");
+	else
+	    break;
+    }
+    return uns;
+}
+
+static int find_var(token_t *t)
+{
+    int i;
+
+    for (i = num_vars - 1; i >= 0; i--)
+	if (vars[i].len == t->len && !strncmp(vars[i].name, t->s, t->len))
+	    return i;
+    return -1;
+}
+
+static void add_var(token_t *t, vec_t *val)
+{
+    if (num_vars == MAX_VARS)
+	parse_error("more than %d variables", MAX_VARS);
+    vars[num_vars].name = t->s;
+    vars[num_vars].len = t->len;
+    vars[num_vars++].val = *val;
+}
+
+static vec_t parse_expr(void);
+
+/*
+ * apply - Return a op b for a binary operator op
+ */
+static vec_t apply(token_t *op, vec_t *a, vec_t *b)
+{
+    int uns = a->uns || b->uns;
+    unsigned x, y;
+    vec_t r;
+
+    if (!exec)
+	return *a;
+    switch (op->s[0]) {
+    case '|':
+    case '&':
+	if (op->len == 2) {
+	    bdd_t f = vec_nonzero(a), g = vec_nonzero(b);
+	    return vec_bool(op->s[0] == '|' ? bdd_or(f, g) : bdd_and(f, g));
+	}
+	/* fall through */
+    case '^':
+	for (x = 0; x < 32; x++)
+	    r.bit[x] = op->s[0] == '|' ? bdd_or(a->bit[x], b->bit[x]) :
+		op->s[0] == '&' ? bdd_and(a->bit[x], b->bit[x]) :
+		bdd_xor(a->bit[x], b->bit[x]);
+	r.uns = uns;
+	return r;
+    case '=':
+	return vec_bool(vec_equal(a, b));
+    case '!':
+	return vec_bool(bdd_not(vec_equal(a, b)));
+    case '<':
+	if (op->len == 2 && op->s[1] == '<')
+	    return vec_shift(a, b, 1);
+	if (op->len == 2)
+	    return vec_bool(bdd_not(vec_less(b, a, uns)));
+	return vec_bool(vec_less(a, b, uns));
+    case '>':
+	if (op->len == 2 && op->s[1] == '>')
+	    return vec_shift(a, b, 0);
+	if (op->len == 2)
+	    return vec_bool(bdd_not(vec_less(a, b, uns)));
+	return vec_bool(vec_less(b, a, uns));
+    case '+':
+	return vec_add(a, b, BDD_0);
+    case '-':
+	r = vec_not(b);
+	return vec_add(a, &r, BDD_1);
+    default:
+	/* * / and % only of constants */
+	if (!vec_value(a, &x) || !vec_value(b, &y))
+	    parse_error("\"%.*s\" is only allowed on constants", op->len,
+			op->s);
+	if (op->s[0] == '*')
+	    return vec_const(x * y, uns);
+	if (y == 0)
+	    parse_error("division by zero");
+	if (uns)
+	    return vec_const(op->s[0] == '/' ? x / y : x % y, 1);
+	return vec_const(op->s[0] == '/' ? (int) x / (int) y :
+			 (int) x % (int) y, 0);
+    }
+}
+
+/* The binary operators, from the lowest precedence up */
+static char *binary_ops[][5] = {
+    {"||"}, {"&&"}, {"|"}, {"^"}, {"&"}, {"==", "!="},
+    {"<", ">", "<=", ">="}, {"<<", ">>"}, {"+", "-"}, {"*", "/", "%"}
+};
+#define NUM_LEVELS (sizeof(binary_ops) / sizeof(binary_ops[0]))
+
+static vec_t parse_unary(void)
+{
+    token_t *t = &toks[pos];
+    vec_t a, zero = vec_const(0, 0);
+    int uns, i;
+
+    if (accept("!")) {
+	a = parse_unary();
+	return exec ? vec_bool(bdd_not(vec_nonzero(&a))) : a;
+    }
+    if (accept("~")) {
+	a = parse_unary();
+	return exec ? vec_not(&a) : a;
+    }
+    if (accept("-")) {
+	a = parse_unary();
+	zero.uns = a.uns;
+	return apply(t, &zero, &a);
+    }
+    if (accept("+"))
+	return parse_unary();
+    if (accept("(")) {
+	/* A cast, or an expression in parentheses */
+	if ((uns = parse_type()) >= 0) {
+	    expect(")");
+	    a = parse_unary();
+	    a.uns = uns;
+	    return a;
+	}
+	a = parse_expr();
+	expect(")");
+	return a;
+    }
+
+    pos++;
+    if (t->kind == TOK_NUM)
+	return vec_const(t->val, t->uns);
+    if (t->kind != TOK_ID || tok_is("sizeof"))
+	parse_error("unexpected \"%.*s\"", t->len, t->s);
+    if (tok_is("(") || tok_is("["))
+	parse_error("%.*s: function calls and arrays aren't allowed",
+		    t->len, t->s);
+    if (!exec)
+	return zero;
+    if ((i = find_var(t)) < 0) {
+	pos--;
+	parse_error("unknown variable %.*s", t->len, t->s);
+    }
+    return vars[i].val;
+}
+
+static vec_t parse_binary(int level)
+{
+    vec_t a, b;
+    token_t *op;
+    int i;
+
+    if (level == NUM_LEVELS)
+	return parse_unary();
+    a = parse_binary(level + 1);
+    for (;;) {
+	op = &toks[pos];
+	for (i = 0; i < 5 && binary_ops[level][i]; i++)
+	    if (tok_is(binary_ops[level][i]))
+		break;
+	if (i == 5 || !binary_ops[level][i])
+	    return a;
+	pos++;
+	b = parse_binary(level + 1);
+	a = apply(op, &a, &b);
+    }
+}
+
+static vec_t parse_expr(void)
+{
+    vec_t c, a, b;
+
+    c = parse_binary(0);
+    if (!accept("?"))
+	return c;
+    a = parse_expr();
+    expect(":");
+    b = parse_expr();
+    return exec ? vec_mux(vec_nonzero(&c), &a, &b) : c;
+}
+
+/*
+ * parse_simple - Run a declaration, or assignments separated by
+ *    commas, up to the ; or )
+ */
+static void parse_simple(void)
+{
+    static char *assign_ops[] = {
+	"=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>=",
+	NULL
+    };
+    token_t *name, *op;
+    vec_t a, b;
+    int uns, i, v;
+
+    if ((uns = parse_type()) >= 0) {
+	do {
+	    name = &toks[pos];
+	    if (name->kind != TOK_ID)
+		parse_error("expected a variable name");
+	    pos++;
+	    a = vec_const(0, uns);
+	    if (accept("="))
+		a = parse_expr();
+	    a.uns = uns;
+	    if (exec)
+		add_var(name, &a);
+	} while (accept(","));
+	return;
+    }
+
+    do {
+	if (accept("++") || accept("--")) {
+	    op = &toks[pos - 1];
+	    name = &toks[pos++];
+	}
+	else {
+	    name = &toks[pos];
+	    if (name->kind != TOK_ID) {
+		parse_expr();
+		continue;
+	    }
+	    pos++;
+	    op = &toks[pos];
+	    for (i = 0; assign_ops[i]; i++)
+		if (tok_is(assign_ops[i]))
+		    break;
+	    if (!assign_ops[i] && !tok_is("++") && !tok_is("--")) {
+		pos--;
+		parse_expr();
+		continue;
+	    }
+	    pos++;
+	}
+
+	v = exec ? find_var(name) : 0;
+	if (v < 0)
+	    parse_error("unknown variable %.*s", name->len, name->s);
+	if (op->len == 2 && op->s[0] == op->s[1] &&
+	    (op->s[0] == '+' || op->s[0] == '-')) {
+	    /* ++ or --, as + or - of 1 */
+	    token_t one = *op;
+
+	    one.len = 1;
+	    b = vec_const(1, 0);
+	    if (exec)
+		vars[v].val = apply(&one, &vars[v].val, &b);
+	    continue;
+	}
+	b = parse_expr();
+	if (!exec)
+	    continue;
+	uns = vars[v].val.uns;
+	if (op->len > 1) {
+	    /* x op= b is x = x op b */
+	    token_t bin = *op;
+
+	    bin.len--;
+	    b = apply(&bin, &vars[v].val, &b);
+	}
+	vars[v].val = b;
+	vars[v].val.uns = uns;
+    } while (accept(","));
+}
+
+/*
+ * concrete - Return the value of a condition c, which mustn't depend
+ *    on the arguments
+ */
+static int concrete(vec_t *c, char *what)
+{
+    unsigned u;
+
+    if (!exec)
+	return 0;
+    if (!vec_value(c, &u))
+	parse_error("%s that depends on the arguments", what);
+    return u != 0;
+}
+
+static void parse_stmt(void)
+{
+    int saved = exec, scope = num_vars;
+    int c, iters, cond, step, end;
+    vec_t v;
+
+    if (accept("{")) {
+	while (!accept("}")) {
+	    if (toks[pos].kind == TOK_END)
+		parse_error("missing }");
+	    parse_stmt();
+	}
+	num_vars = scope;
+	return;
+    }
+    if (accept(";"))
+	return;
+    if (accept("return")) {
+	v = parse_expr();
+	expect(";");
+	if (exec) {
+	    result = v;
+	    returned = 1;
+	    exec = 0;
+	}
+	return;
+    }
+    if (accept("if")) {
+	expect("(");
+	v = parse_expr();
+	c = concrete(&v, "an if");
+	expect(")");
+	exec = saved && c;
+	parse_stmt();
+	if (accept("else")) {
+	    exec = saved && !c && !returned;
+	    parse_stmt();
+	}
+	exec = saved && !returned;
+	return;
+    }
+    if (accept("for")) {
+	expect("(");
+	if (!tok_is(";"))
+	    parse_simple();
+	expect(";");
+	cond = pos;
+	for (iters = 0; ; iters++) {
+	    pos = cond;
+	    c = 1;
+	    if (!tok_is(";")) {
+		v = parse_expr();
+		c = concrete(&v, "a loop");
+	    }
+	    expect(";");
+	    step = pos;
+	    exec = 0;
+	    if (!tok_is(")"))
+		parse_simple();
+	    expect(")");
+	    exec = saved && c && !returned;
+	    parse_stmt();
+	    end = pos;
+	    if (!exec)
+		break;
+	    if (iters == MAX_ITERS)
+		parse_error("a loop of more than %d iterations", MAX_ITERS);
+	    pos = step;
+	    if (!tok_is(")"))
+		parse_simple();
+	}
+	pos = end;
+	exec = saved && !returned;
+	num_vars = scope;
+	return;
+    }
+    if (tok_is("while") || tok_is("do") || tok_is("switch") ||
+	tok_is("goto") || tok_is("break") || tok_is("continue"))
+	parse_error("%.*s statements aren't allowed", toks[pos].len,
+		    toks[pos].s);
+
+    parse_simple();
+    expect(";");
+}
+
+/*
+ * run_function - Run function name, whose source is in src, on the
+ *    bits of its arguments. Return the value it returns.
+ */
+static vec_t run_function(char *src, char *name)
+{
+    token_t *t;
+    vec_t arg;
+    int i, k, uns, depth;
+
+    tokenize(src);
+
+    /* Find its definition: the name after a type, and a { after the
+       parameters */
+    for (pos = 1; pos < num_toks; pos++) {
+	t = &toks[pos];
+	if (t->kind != TOK_ID || t->len != strlen(name) ||
+	    strncmp(t->s, name, t->len) || toks[pos - 1].kind != TOK_ID ||
+	    toks[pos + 1].kind != TOK_OP || toks[pos + 1].s[0] != '(')
+	    continue;
+	for (i = pos + 1, depth = 0; i < num_toks; i++) {
+	    if (toks[i].kind == TOK_OP && toks[i].s[0] == '(')
+		depth++;
+	    if (toks[i].kind == TOK_OP && toks[i].s[0] == ')' && --depth == 0)
+		break;
+	}
+	if (i + 1 < num_toks && toks[i + 1].kind == TOK_OP &&
+	    toks[i + 1].s[0] == '{')
+	    break;
+    }
+    if (pos >= num_toks)
+	check_error("%s: can't find the definition of %s", where, name);
+
+    /* The parameters are the arguments */
+    pos += 2;
+    num_vars = 0;
+    exec = 1;
+    returned = 0;
+    accept("void");
+    for (k = 0; !accept(")"); k++) {
+	if (k > 0)
+	    expect(",");
+	if ((uns = parse_type()) < 0 || toks[pos].kind != TOK_ID || k == 3)
+	    parse_error("bad parameter list");
+	for (i = 0; i < 32; i++)
+	    arg.bit[i] = i < arg_bits[k] ?
+		bdd_node(BIT_VAR(k, i), BDD_0, BDD_1) : BDD_0;
+	arg.uns = uns;
+	add_var(&toks[pos++], &arg);
+    }
+
+    if (!tok_is("{"))
+	parse_error("expected {");
+    parse_stmt();
+    if (!returned)
+	check_error("%s: %s doesn't return a value", where, name);
+    return result;
+}
+
+/****************
+ * Specifications
+ ****************/
+
+/* What the test functions in tests.c compute, in the language above */
+static struct {
+    char *name;
+    char *src;
+} specs[] = {
+    {"bitOr",
+     "int test_bitOr(int x, int y) { return x | y; }"},
+    {"thirdBits",
+     "int test_thirdBits(void) {"
+     "  int result = 0;"
+     "  int i;"
+     "  for (i = 0; i < 32; i += 3)"
+     "    result |= 1 << i;"
+     "  return result;"
+     "}"},
+    {"anyOddBit",
+     "int test_anyOddBit(int x) {"
+     "  int result = 0;"
+     "  int i;"
+     "  for (i = 1; i < 32; i += 2)"
+     "    result |= (x >> i) & 1;"
+     "  return result;"
+     "}"},
+    {"getByte",
+     "int test_getByte(int x, int n) {"
+     "  return n == 0 ? x & 0xFF :"
+     "         n == 1 ? (x >> 8) & 0xFF :"
+     "         n == 2 ? (x >> 16) & 0xFF :"
+     "         (x >> 24) & 0xFF;"
+     "}"},
+    {"replaceByte",
+     "int test_replaceByte(int x, int n, int c) {"
+     "  return n == 0 ? (x & 0xFFFFFF00) | c :"
+     "         n == 1 ? (x & 0xFFFF00FF) | (c << 8) :"
+     "         n == 2 ? (x & 0xFF00FFFF) | (c << 16) :"
+     "         (x & 0x00FFFFFF) | (c << 24);"
+     "}"},
+    {"bitParity",
+     "int test_bitParity(int x) {"
+     "  int result = 0;"
+     "  int i;"
+     "  for (i = 0; i < 32; i++)"
+     "    result ^= (x >> i) & 0x1;"
+     "  return result;"
+     "}"},
+    {"isTmin",
+     "int test_isTmin(int x) { return x == 0x80000000; }"},
+    {"negate",
+     "int test_negate(int x) { return -x; }"},
+    {"addOK",
+     "int test_addOK(int x, int y) {"
+     "  int sum = x + y;"
+     "  return (x < 0) != (y < 0) || (sum < 0) == (x < 0);"
+     "}"},
+    {"isGreater",
+     "int test_isGreater(int x, int y) { return x > y; }"},
+    {"isNonZero",
+     "int test_isNonZero(int x) { return x != 0; }"},
+    {NULL, NULL}
+};
+
+/***************
+ * The checker
+ ***************/
+
+/*
+ * call - Return f(args), for a function f of n arguments
+ */
+static int call(funct_t f, int n, int *args)
+{
+    switch (n) {
+    case 0:
+	return f();
+    case 1:
+	return ((funct1_t) f)(args[0]);
+    case 2:
+	return ((funct2_t) f)(args[0], args[1]);
+    default:
+	return ((funct3_t) f)(args[0], args[1], args[2]);
+    }
+}
+
+static int vec_eval(vec_t *a, int *args)
+{
+    unsigned u = 0;
+    int i;
+
+    for (i = 0; i < 32; i++)
+	u |= (unsigned) bdd_eval(a->bit[i], args) << i;
+    return u;
+}
+
+/*
+ * check_input - Put the arguments of the i'th input that the
+ *    solution and the specification are run on in args: combinations
+ *    of special values, and then random ones, moved into range
+ */
+static void check_input(test_ptr t, int i, int *args, unsigned *seed)
+{
+    static unsigned special[] = {
+	0, 1, 2, 3, 7, 8, 0x7f, 0x80, 0xff, 0x100, 0xffff, 0x10000,
+	0x55555555, 0xaaaaaaaa, 0x7fffffff, 0x80000000, 0x80000001,
+	0xfffffffe, 0xffffffff, 0xffffff00, 0xff
+    };
+    int nspecial = sizeof(special) / sizeof(special[0]);
+    unsigned v, span;
+    int k;
+
+    for (k = 0; k < t->args; k++) {
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	if (i < nspecial * nspecial)
+	    v = special[k == 0 ? i % nspecial : (i / nspecial + k) % nspecial];
+	else
+	    v = *seed;
+	span = (unsigned) t->arg_ranges[k][1] - t->arg_ranges[k][0] + 1;
+	args[k] = span ? t->arg_ranges[k][0] + v % span : (int) v;
+    }
+}
+
+/*
+ * args_text - Return the arguments in args of function t as text
+ */
+static char *args_text(test_ptr t, int *args)
+{
+    static char buf[64];
+    int k;
+
+    buf[0] = '\0';
+    for (k = 0; k < t->args; k++)
+	sprintf(buf + strlen(buf), "%s0x%x", k ? ", " : "", args[k]);
+    return buf;
+}
+
+int bdd_check(test_ptr t, char *src, int *args, int *nodes_used,
+	      char *why, int whylen)
+{
+    vec_t sol, spec, lo, hi, var;
+    unsigned seed = 0x2545f491;
+    char name[64];
+    int r, rt, rs, rb, i, k;
+    bdd_t diff, range;
+    char *spec_src = NULL;
+
+    *nodes_used = 0;
+    check_why = why;
+    check_whylen = whylen;
+    if (setjmp(check_env)) {
+	*nodes_used = num_nodes;
+	return BDD_UNKNOWN;
+    }
+
+    if (t->arg_ranges[0][0] == 1 && t->arg_ranges[0][1] == 1)
+	check_error("floating point puzzles can't be checked");
+    for (i = 0; specs[i].name; i++)
+	if (!strcmp(specs[i].name, t->name))
+	    spec_src = specs[i].src;
+    if (spec_src == NULL)
+	check_error("there is no specification of test_%s", t->name);
+
+    for (k = 0; k < 3; k++) {
+	arg_bits[k] = 32;
+	if (k < t->args && t->arg_ranges[k][0] == 0)
+	    while (arg_bits[k] > 0 &&
+		   (unsigned) t->arg_ranges[k][1] < 1u << (arg_bits[k] - 1))
+		arg_bits[k]--;
+    }
+
+    bdd_reset();
+    where = "the specification";
+    snprintf(name, sizeof(name), "test_%s", t->name);
+    spec = run_function(spec_src, name);
+    where = "bits.c";
+    sol = run_function(src, t->name);
+
+    /* Check both against the compiled code on some inputs first */
+    for (i = 0; i < CHECK_INPUTS; i++) {
+	check_input(t, i, args, &seed);
+	r = call(t->solution_funct, t->args, args);
+	rt = call(t->test_funct, t->args, args);
+	rs = vec_eval(&spec, args);
+	rb = vec_eval(&sol, args);
+	if (rs != rt)
+	    check_error("the specification of test_%s gives 0x%x, not "
+			"0x%x, for (%s)", t->name, rs, rt, args_text(t, args));
+	if (r != rt) {
+	    *nodes_used = num_nodes;
+	    return BDD_DIFFERENT;
+	}
+	if (rb != r)
+	    check_error("%s in bits.c gives 0x%x, but the compiled one "
+			"gives 0x%x, for (%s)", t->name, rb, r,
+			args_text(t, args));
+    }
+
+    /* The inputs in range where any bit of the results differs. Each
+       bit is limited to the range first, so that differences outside
+       it don't make the BDDs big. */
+    range = BDD_1;
+    for (k = 0; k < t->args; k++) {
+	for (i = 0; i < 32; i++)
+	    var.bit[i] = i < arg_bits[k] ?
+		bdd_node(BIT_VAR(k, i), BDD_0, BDD_1) : BDD_0;
+	lo = vec_const(t->arg_ranges[k][0], 0);
+	hi = vec_const(t->arg_ranges[k][1], 0);
+	range = bdd_and(range, bdd_not(vec_less(&var, &lo, 0)));
+	range = bdd_and(range, bdd_not(vec_less(&hi, &var, 0)));
+    }
+    diff = BDD_0;
+    for (i = 0; i < 32; i++)
+	diff = bdd_or(diff, bdd_and(range, bdd_xor(sol.bit[i], spec.bit[i])));
+    *nodes_used = num_nodes;
+    if (diff == BDD_0)
+	return BDD_EQUAL;
+
+    bdd_witness(diff, args);
+    r = call(t->solution_funct, t->args, args);
+    rt = call(t->test_funct, t->args, args);
+    if (r != rt)
+	return BDD_DIFFERENT;
+    snprintf(why, whylen, "%s in bits.c gives 0x%x for (%s), but the "
+	     "compiled one doesn't", t->name, vec_eval(&sol, args),
+	     args_text(t, args));
+    return BDD_UNKNOWN;
+}
@@ -0,0 +1,27 @@
+/*
+ * bddcheck.h - prototypes for the BDD checker in bddcheck.c, which
+ *     proves that a solution in bits.c gives the same results as its
+ *     test function on every input
+ */
+#ifndef __BDDCHECK_H_
+#define __BDDCHECK_H_
+
+/* The results of bdd_check */
+#define BDD_EQUAL     0   /* the same on every input in range */
+#define BDD_DIFFERENT 1   /* args holds an input where they differ */
+#define BDD_UNKNOWN   2   /* couldn't tell, and why says why */
+
+/*
+ * bdd_check - Compare the solution of function t, whose source is in
+ *     the text of bits.c in src, with its test function. The solution
+ *     and a specification of the test function are turned into BDDs
+ *     of each bit of their results, over every bit of the arguments.
+ *     Inputs where the compiled solution differs are put in args (and
+ *     are always confirmed by calling it). The number of BDD nodes
+ *     used is put in *nodes. Returns BDD_EQUAL, BDD_DIFFERENT, or
+ *     BDD_UNKNOWN, with a message of up to whylen bytes in why.
+ */
+int bdd_check(test_ptr t, char *src, int *args, int *nodes,
+	      char *why, int whylen);
+
+#endif /* __BDDCHECK_H_ */
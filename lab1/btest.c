@@ -21,7 +21,18 @@
 #include <signal.h>
 #include <setjmp.h>
 #include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <poll.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "btest.h"
+#include "bddcheck.h"
 
 /* Not declared in some stdlib.h files, so define here */
 float strtof(const char *nptr, char **endptr);
@@ -41,11 +52,77 @@ float strtof(const char *nptr, char **endptr);
    explosion */
 #define TEST_RANGE 500000
 
-/* This defines the maximum size of any test value array. The
-   gen_vals() routine creates k test values for each value of
-   TEST_RANGE, thus MAX_TEST_VALS must be at least k*TEST_RANGE */
+/* An argument whose range has at most this many values is tested on
+   every one of them, rather than on samples */
 #define MAX_TEST_VALS 13*TEST_RANGE
 
+/* The kinds of streams of test values for an argument (see gen_t) */
+#define GEN_FIXED  0  /* the value given with -1, -2, or -3 */
+#define GEN_FLOAT  1  /* regions of interesting float bit patterns */
+#define GEN_ALL    2  /* every value in a small range */
+#define GEN_SAMPLE 3  /* near the boundaries and zero, and random ones */
+
+/* Tests are run in batches of this many: the solution and the test
+   function are each called on the whole batch, and then the results
+   are compared */
+#define BATCH_TESTS 1024
+
+/* The batch versions of the test functions are checked against the
+   test functions on this many arguments before they are used */
+#define CHECK_TESTS 65536
+
+/* With -j, the worker threads take the values of a function's first
+   argument in chunks that each make about this many calls */
+#define CHUNK_TESTS 16384
+
+/* With -e, one-argument functions are checked on all 2^32 inputs,
+   comparing the results SWEEP_BLOCK at a time */
+#define SWEEP_BLOCK 4096
+#define SWEEP_BLOCKS ((int) (0x100000000LL / SWEEP_BLOCK))
+
+/* With -e and -p, the worker processes check a function's inputs
+   this many blocks at a time, each with its own time limit */
+#define ISO_SWEEP_BLOCKS 4096
+
+/* With -c, each argument takes the values of these classes of bit
+   patterns instead (see class_table), and every combination of them
+   is tested */
+#define CLASS_SINGLE 0  /* one bit set */
+#define CLASS_ALLBUT 1  /* all bits but one set */
+#define CLASS_BYTE   2  /* at and next to byte boundaries */
+#define CLASS_SIGN   3  /* with and without the sign bit, and negated */
+#define CLASS_ZERO   4  /* near zero */
+#define CLASS_EXP    5  /* smallest and largest float of each exponent */
+#define CLASS_NAN    6  /* NaNs with one payload bit set, and others */
+#define CLASS_RANGE  7  /* every value in a small range */
+#define CLASS_FIXED  8  /* the value given with -1, -2, or -3 */
+#define NUM_CLASSES  9
+
+/* Most values in all the classes together */
+#define MAX_CLASS_VALS 2048
+
+/* With -c, an argument whose range has at most this many values is
+   tested on every one of them */
+#define MAX_RANGE_VALS 256
+
+/* With -F, the inputs of a function's corpus that are kept in memory
+   (see fuzz_test), and how many there are at least, starting from
+   values of the classes above */
+#define FUZZ_CORPUS 4096
+#define FUZZ_SEEDS  64
+
+/* The number of kinds of results (see result_kind) */
+#define FUZZ_KINDS  (33*33)
+
+/* With -b, each function is timed with the K-best scheme of fcyc in
+   malloclab: samples are taken until the K fastest are within EPSILON
+   of each other, or there have been MAXSAMPLES of them. Each sample
+   calls the function BENCH_REPS times on each of a batch of tests. */
+#define BENCH_K          3
+#define BENCH_MAXSAMPLES 20
+#define BENCH_EPSILON    0.01
+#define BENCH_REPS       64
+
 /**********************************
  * Globals defined in other modules 
  **********************************/
@@ -74,348 +151,2059 @@ static unsigned argval[3] = {0,0,0};
 /* Use fixed weight for rating, and if so, what should it  be? (-r) */
 static int global_rating = 0;
 
+/* Number of worker threads, or 1 to test on the main thread (-j) */
+static int num_threads = 0; /* 0 means one, or one per CPU with -e */
+
+/* Check one-argument functions on every possible input (-e) */
+static int exhaustive = 0;
+
+/* Test the arguments on classes of bit patterns (-c) */
+static int classes = 0;
+
+/* Number of worker processes to test in, or 0 not to use them (-p) */
+static int num_procs = 0;
+
+/* With -p, time out after this many milliseconds (-t, or -T) */
+static long iso_timeout_ms = -1;
+
+/* Prove the functions correct with the BDD checker, where it can (-P) */
+static int prove = 0;
+
+/* The source of bits.c, for the BDD checker */
+static char *bits_src = NULL;
+
+/* Time the functions instead of testing them (-b) */
+static int bench = 0;
+
+/* Fuzz each function for this many seconds (-F) */
+static int fuzz_secs = 0;
+
+/* Directory of the fuzzing corpus, with a file for each function (-D) */
+static char *corpus_dir = NULL;
+
+/* Seed of the fuzzer's mutations, from the clock unless given (-s) */
+static unsigned fuzz_seed = 0;
+static int has_fuzz_seed = 0;
+
+/* The first test of a function that failed */
+typedef struct {
+    int found;     /* set if some test failed */
+    int index;     /* index of its first argument among the test values */
+    int args[3];   /* its arguments */
+    int r, rt;     /* the result, and what the result should have been */
+} fail_t;
+
+/* batch_refs[i] has the batch version of test_set[i].test_funct, or
+   is NULL if there isn't one (or it failed its check) */
+static batch_rec **batch_refs = NULL;
+
+/* A batch of tests of one function */
+typedef struct {
+    int n;                          /* number of tests */
+    int index[BATCH_TESTS];         /* index of each one's first arg */
+    int args[3][BATCH_TESTS];       /* their arguments */
+    int r[BATCH_TESTS];             /* the results */
+    int rt[BATCH_TESTS];            /* and what they should be */
+} batch_t;
+
+/* 
+ * The test values of one argument, made on demand a chunk at a time
+ * (see gen_next), so that none of the arrays need to hold them all. 
+ * The values come from a sequence of steps, each of which makes a few
+ * of them. Each stream has its own state for its random values.
+ */
+typedef struct {
+    int kind;           /* GEN_FIXED, GEN_FLOAT, GEN_ALL, or GEN_SAMPLE */
+    int min, max;       /* range of the argument */
+    int range;          /* number of steps near each boundary */
+    int count;          /* number of values in the stream */
+    int pos;            /* number made so far */
+    int step;           /* the next step */
+    int buf[16];        /* values made by the last step... */
+    int nbuf, next;     /* ...how many, and which one is next */
+    unsigned seed;      /* state of the random values */
+} gen_t;
+
+/* A work item of the worker threads (-j): the tests whose first
+   argument is one of the values lo..hi-1 */
+typedef struct {
+    int lo, hi;
+    gen_t first;        /* the stream of first-argument values at lo */
+} item_t;
+
+/* A function being tested, on the main thread or by the worker
+   threads (-j) */
+typedef struct {
+    test_ptr t;
+    gen_t first;        /* the values of the first argument, */
+    int *vals[3];       /* those of the second and third (vals[0] isn't
+			   used), */
+    int counts[3];      /* and how many each argument has */
+    int chunk;          /* first-argument values per work item */
+    int next;           /* first one not handed out yet */
+    int finished;       /* number whose tests are done */
+    int sweep;          /* set if all inputs are checked, in blocks (-e) */
+    int timed_out;      /* set if a work item ran past its deadline */
+    item_t *redo;       /* work items to run again after a restart */
+    int nredo;          /* and how many there are */
+    fail_t fail;        /* the first failure in sequential order */
+} job_t;
+
+/* What a worker thread is doing */
+typedef struct {
+    job_t *job;                /* job of its work item, or NULL */
+    item_t item;               /* the work item */
+    struct timespec deadline;  /* when that work item times out */
+} slot_t;
+
+/* How a job of the isolation pool (-p) ended, in memory shared with
+   the worker processes */
+typedef struct {
+    int state;          /* ISO_WAITING, ISO_DONE, ... */
+    int status;         /* wait status of the worker, if it crashed */
+    fail_t fail;        /* the first failure, if the tests ran */
+} iso_result_t;
+
+#define ISO_WAITING   0  /* not over yet */
+#define ISO_DONE      1  /* the tests ran (and may have failed) */
+#define ISO_CRASHED   2  /* the worker died */
+#define ISO_TIMED_OUT 3  /* the worker was killed at the deadline */
+#define ISO_SKIPPED   4  /* not needed, since an earlier one failed */
+
+/* A job of the isolation pool: the tests of a function, or with -e,
+   blocks lo..hi-1 of its inputs */
+typedef struct {
+    test_ptr t;
+    int lo, hi;         /* or -1 if it is all the usual tests */
+} iso_job_t;
+
+/* A worker process of the isolation pool */
+typedef struct {
+    pid_t pid;                /* or 0 if it isn't running */
+    int cmd;                  /* pipe for the numbers of its jobs */
+    int done;                 /* pipe it writes a byte to after each */
+    int job;                  /* the job it is running, or -1 */
+    struct timespec started;  /* when that job was handed out */
+} proc_t;
+
+static iso_job_t *iso_jobs = NULL;
+static iso_result_t *iso_results = NULL;
+static int iso_count = 0;            /* number of jobs */
+static int *iso_first = NULL;        /* first job of each function */
+static int iso_next = 0;             /* first one not handed out yet */
+static proc_t *procs = NULL;         /* one for each worker process */
+static struct pollfd *iso_fds = NULL;
+static proc_t **iso_busy = NULL;
+
+static job_t *jobs = NULL;       /* one for each function tested */
+static int num_jobs = 0;
+static pthread_t *threads = NULL;
+static slot_t *slots = NULL;     /* one for each thread */
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signalled when a work item is started or a job is finished */
+static pthread_cond_t job_event = PTHREAD_COND_INITIALIZER;
+
 /******************
  * Helper functions
  ******************/
 
 /*
- * Signal - installs a signal handler
+ * Signal - installs a signal handler
+ */
+typedef void handler_t(int);
+
+handler_t *Signal(int signum, handler_t *handler) 
+{
+    struct sigaction action, old_action;
+
+    action.sa_handler = handler;  
+    sigemptyset(&action.sa_mask); /* block sigs of type being handled */
+    action.sa_flags = SA_RESTART; /* restart syscalls if possible */
+
+    if (sigaction(signum, &action, &old_action) < 0)
+	perror("Signal error");
+    return (old_action.sa_handler);
+}
+
+/* 
+ * timeout_handler - SIGALARM hander 
+ */
+sigjmp_buf envbuf;
+void timeout_handler(int sig) {
+    siglongjmp(envbuf, 1);
+}
+
+/* 
+ * random_val - Return random integer value between min and max, 
+ *    using and updating the random state in *seedp
+ */
+static int random_val(int min, int max, unsigned *seedp)
+{
+    double weight = rand_r(seedp)/(double) RAND_MAX;
+    int result = min * (1-weight) + max * weight;
+    return result;
+}
+
+/* 
+ * gen_init - Start a stream of the values we'll use to test argument
+ *    arg, whose values are between min and max. seed starts its
+ *    random values.
+ */
+static void gen_init(gen_t *g, int min, int max, int test_range, int arg,
+		     unsigned seed)
+{
+    int i;
+
+    memset(g, 0, sizeof(*g));
+    g->min = min;
+    g->max = max;
+    g->seed = seed;
+
+    /* Special case: If the user has specified a specific function
+       argument using the -1, -2, or -3 flags, then simply use this
+       argument */
+    if (has_arg[arg]) {
+	g->kind = GEN_FIXED;
+	g->min = g->max = argval[arg];
+	g->count = 1;
+    }
+
+    /* Special case: Floating point functions, where the input
+       argument is an unsigned bit-level representation of a float. 
+       Test range should be at most 1/2 the range of one exponent
+       value. */
+    else if (min == 1 && max == 1) { 
+	g->kind = GEN_FLOAT;
+	g->range = test_range > (1 << 23) ? (1 << 23) : test_range;
+	g->count = 12 * g->range + 4;
+    }
+
+    /* If the range is small enough, then do exhaustively */
+    else if ((long long) max - min <= MAX_TEST_VALS) {
+	g->kind = GEN_ALL;
+	g->count = max - min + 1;
+    }
+
+    /* Otherwise, need to sample */
+    else {
+	g->kind = GEN_SAMPLE;
+	g->range = test_range;
+	for (i = 0; i < test_range; i++)
+	    g->count += 3 + (i >= min && i <= max) + (-i >= min && -i <= max);
+    }
+}
+
+/* 
+ * gen_step - Make the values of the next step of the stream 
+ */
+static void gen_step(gen_t *g)
+{
+    unsigned smallest_norm = 0x00800000;
+    unsigned one = 0x3f800000;
+    unsigned largest_norm = 0x7f000000;
+    unsigned inf = 0x7f800000;
+    unsigned nan =  0x7fc00000;
+    unsigned sign = 0x80000000;
+    int i = g->step++;
+    int *v = g->buf;
+    int n = 0;
+
+    switch (g->kind) {
+    case GEN_FIXED:
+	v[n++] = g->min;
+	break;
+
+    case GEN_FLOAT:
+	/* Test the regions around zero, the smallest normalized and
+	   largest denormalized numbers, one, and the largest
+	   normalized number, and then inf and nan */
+	if (i < g->range) {
+	    /* Denorms around zero */
+	    v[n++] = i; 
+	    v[n++] = sign | i;
+	    
+	    /* Region around norm to denorm transition */
+	    v[n++] = smallest_norm + i;
+	    v[n++] = smallest_norm - i;
+	    v[n++] = sign | (smallest_norm + i);
+	    v[n++] = sign | (smallest_norm - i);
+	    
+	    /* Region around one */
+	    v[n++] = one + i;
+	    v[n++] = one - i;
+	    v[n++] = sign | (one + i);
+	    v[n++] = sign | (one - i);
+	    
+	    /* Region below largest norm */
+	    v[n++] = largest_norm - i; 
+	    v[n++] = sign | (largest_norm - i); 
+	}
+	else {
+	    /* special vals */
+	    v[n++] = inf;        /* inf */
+	    v[n++] = sign | inf; /* -inf */
+	    v[n++] = nan;        /* nan */
+	    v[n++] = sign | nan; /* -nan */
+	}
+	break;
+
+    case GEN_ALL:
+	v[n++] = g->min + i;
+	break;
+
+    default: 
+	/* Test around the boundaries */
+	v[n++] = g->min + i;
+	v[n++] = g->max - i;
+
+	/* If zero falls between min and max, then also test around zero */
+	if (i >= g->min && i <= g->max)
+	    v[n++] = i;
+	if (-i >= g->min && -i <= g->max)
+	    v[n++] = -i;
+
+	/* Random case between min and max */
+	v[n++] = random_val(g->min, g->max, &g->seed);
+	break;
+    }
+    g->nbuf = n;
+    g->next = 0;
+}
+
+/* 
+ * gen_next - Store the next (up to) n values of the stream in vals.
+ *    Return how many there were, which is 0 at the end.
+ */
+static int gen_next(gen_t *g, int *vals, int n)
+{
+    int k = 0;
+
+    while (k < n && g->pos < g->count) {
+	if (g->next == g->nbuf)
+	    gen_step(g);
+	vals[k++] = g->buf[g->next++];
+	g->pos++;
+    }
+    return k;
+}
+
+/* 
+ * test_0_arg - Test a function with zero arguments 
+ */
+static int test_0_arg(funct_t f, funct_t ft, fail_t *fail)
+{
+    int r = f();
+    int rt = ft();
+    int error =  (r != rt);
+
+    if (error) {
+	fail->r = r;
+	fail->rt = rt;
+    }
+    return error;
+}
+
+/* 
+ * test_1_batch - Test a function with one argument on a batch 
+ */
+static void test_1_batch(funct_t f, funct_t ft, batch_rec *bt, batch_t *b)
+{
+    funct1_t f1 = (funct1_t) f;
+    funct1_t f1t = (funct1_t) ft;
+    int i;
+
+    for (i = 0; i < b->n; i++)
+	b->r[i] = f1(b->args[0][i]);
+    if (bt) {
+	bt->batch1(b->args[0], b->rt, b->n);
+	return;
+    }
+    for (i = 0; i < b->n; i++)
+	b->rt[i] = f1t(b->args[0][i]);
+}
+
+/* 
+ * test_2_batch - Test a function with two arguments on a batch 
+ */
+static void test_2_batch(funct_t f, funct_t ft, batch_rec *bt, batch_t *b)
+{
+    funct2_t f2 = (funct2_t) f;
+    funct2_t f2t = (funct2_t) ft;
+    int i;
+
+    for (i = 0; i < b->n; i++)
+	b->r[i] = f2(b->args[0][i], b->args[1][i]);
+    if (bt) {
+	bt->batch2(b->args[0], b->args[1], b->rt, b->n);
+	return;
+    }
+    for (i = 0; i < b->n; i++)
+	b->rt[i] = f2t(b->args[0][i], b->args[1][i]);
+}
+
+/* 
+ * test_3_batch - Test a function with three arguments on a batch 
+ */
+static void test_3_batch(funct_t f, funct_t ft, batch_t *b)
+{
+    funct3_t f3 = (funct3_t) f;
+    funct3_t f3t = (funct3_t) ft;
+    int i;
+
+    for (i = 0; i < b->n; i++)
+	b->r[i] = f3(b->args[0][i], b->args[1][i], b->args[2][i]);
+    for (i = 0; i < b->n; i++)
+	b->rt[i] = f3t(b->args[0][i], b->args[1][i], b->args[2][i]);
+}
+
+/* 
+ * first_mismatch - Return the index of the first of the n results in
+ *    r that differs from the one in rt, or n if they are all equal.
+ *    With SSE2, four results are compared at once, and only the group
+ *    of four with the mismatch is looked at one by one.
+ */
+static int first_mismatch(int *r, int *rt, int n)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128i eq;
+
+    for (; i + 4 <= n; i += 4) {
+	eq = _mm_cmpeq_epi32(_mm_loadu_si128((__m128i *) (r + i)),
+			     _mm_loadu_si128((__m128i *) (rt + i)));
+	if (_mm_movemask_epi8(eq) != 0xffff)
+	    break;
+    }
+#endif
+    for (; i < n; i++)
+	if (r[i] != rt[i])
+	    break;
+    return i;
+}
+
+/* 
+ * run_batch - Run the tests in batch b of function t, filling in
+ *    their results
+ */
+static void run_batch(test_ptr t, batch_t *b)
+{
+    switch (t->args) {
+    case 1:
+	test_1_batch(t->solution_funct, t->test_funct, 
+		     batch_refs[t - test_set], b);
+	break;
+    case 2:
+	test_2_batch(t->solution_funct, t->test_funct, 
+		     batch_refs[t - test_set], b);
+	break;
+    default:
+	test_3_batch(t->solution_funct, t->test_funct, b);
+	break;
+    }
+}
+
+/* 
+ * check_batch - Run the tests in batch b of function t and empty it.
+ *    Return the number of errors (0 or 1) and describe the first
+ *    failure in fail.
+ */
+static int check_batch(test_ptr t, batch_t *b, fail_t *fail)
+{
+    int i, k;
+
+    run_batch(t, b);
+    i = first_mismatch(b->r, b->rt, b->n);
+    if (i == b->n) {
+	b->n = 0;
+	return 0;
+    }
+
+    fail->found = 1;
+    fail->index = b->index[i];
+    for (k = 0; k < t->args; k++)
+	fail->args[k] = b->args[k][i];
+    fail->r = b->r[i];
+    fail->rt = b->rt[i];
+    b->n = 0;
+    return 1;
+}
+
+/* 
+ * report_failure - Print the test of function t that failed 
+ */
+static void report_failure(test_ptr t, fail_t *fail)
+{
+    char *name = t->name;
+    int *a = fail->args;
+    int r = fail->r, rt = fail->rt;
+
+    if (grade)
+	return;
+    switch (t->args) {
+    case 0:
+	printf("ERROR: Test %s() failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, r, r, rt, rt);
+	break;
+    case 1:
+	printf("ERROR: Test %s(%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, a[0], a[0], r, r, rt, rt);
+	break;
+    case 2:
+	printf("ERROR: Test %s(%d[0x%x],%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, a[0], a[0], a[1], a[1], r, r, rt, rt);
+	break;
+    default:
+	printf("ERROR: Test %s(%d[0x%x],%d[0x%x],%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, a[0], a[0], a[1], a[1], a[2], a[2], r, r, rt, rt);
+	break;
+    }
+}
+
+/* 
+ * check_batch_ref - Return true if the batch version bt of the test
+ *    function of t gives the same results as the test function on
+ *    CHECK_TESTS arguments: special integer and float values, every
+ *    single-bit pattern and its complement, and pseudo-random values.
+ */
+static int check_batch_ref(test_ptr t, batch_rec *bt)
+{
+    static unsigned special[] = {
+	0, 1, 2, 3, 0x7f, 0x80, 0xff, 0x100, 0xffff, 0x10000,
+	0x7fffffff, 0x80000000, 0x80000001, 0xfffffffe, 0xffffffff,
+	0x00800000, 0x007fffff, 0x3f800000, 0x7f000000, 0x7f7fffff,
+	0x7f800000, 0x7f800001, 0x7fc00000, 0x4f000000, 0x4effffff,
+	0xcf000000, 0xcf000001, 0x3f000000, 0xbf7fffff, 0x80800000
+    };
+    int nspecial = sizeof(special) / sizeof(special[0]);
+    int *x, *y, *r, *rt;
+    unsigned seed = 0x2545f491;
+    int i, ok;
+
+    x = malloc(4 * CHECK_TESTS * sizeof(int));
+    if (x == NULL) {
+	printf("Out of memory\n");
+	exit(1);
+    }
+    y = x + CHECK_TESTS;
+    r = y + CHECK_TESTS;
+    rt = r + CHECK_TESTS;
+
+    for (i = 0; i < CHECK_TESTS; i++) {
+	/* xorshift32 */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	if (i < 2 * nspecial)
+	    x[i] = special[i % nspecial] | (i >= nspecial ? 0x80000000 : 0);
+	else if (i < 2 * nspecial + 64)
+	    x[i] = (i & 1 ? ~0u : 0u) ^ (1u << ((i / 2) % 32));
+	else
+	    x[i] = seed;
+	y[i] = (i % 3 == 0) ? x[i] : (i % 3 == 1) ? special[seed % nspecial] 
+	    : (int) (seed >> 7 | seed << 25);
+    }
+
+    if (bt->batch1) {
+	bt->batch1(x, r, CHECK_TESTS);
+	for (i = 0; i < CHECK_TESTS; i++)
+	    rt[i] = ((funct1_t) t->test_funct)(x[i]);
+    }
+    else {
+	bt->batch2(x, y, r, CHECK_TESTS);
+	for (i = 0; i < CHECK_TESTS; i++)
+	    rt[i] = ((funct2_t) t->test_funct)(x[i], y[i]);
+    }
+
+    i = first_mismatch(r, rt, CHECK_TESTS);
+    ok = (i == CHECK_TESTS);
+    if (!ok)
+	fprintf(stderr, "Warning: batch version of test_%s gives 0x%x for "
+		"0x%x (0x%x), not 0x%x. Using test_%s.\n", t->name, r[i], 
+		x[i], y[i], rt[i], t->name);
+    free(x);
+    return ok;
+}
+
+/* 
+ * init_batch_refs - Find the batch version of each test function, 
+ *    and check it
+ */
+static void init_batch_refs(void)
+{
+    batch_rec *bt;
+    int i, n;
+
+    for (n = 0; test_set[n].solution_funct; n++)
+	;
+    batch_refs = calloc(n, sizeof(batch_rec *));
+    if (batch_refs == NULL) {
+	printf("Out of memory\n");
+	exit(1);
+    }
+    for (i = 0; i < n; i++) {
+	if (test_fname && strcmp(test_set[i].name, test_fname) != 0)
+	    continue;
+	for (bt = batch_set; bt->name; bt++)
+	    if (strcmp(bt->name, test_set[i].name) == 0 &&
+		((test_set[i].args == 1 && bt->batch1) || 
+		 (test_set[i].args == 2 && bt->batch2)))
+		break;
+	if (bt->name && check_batch_ref(&test_set[i], bt))
+	    batch_refs[i] = bt;
+    }
+}
+
+/* 
+ * init_job - Start the streams of test values for each argument of
+ *    function t. The values of the second and third arguments are 
+ *    tried with every value of the first, so they are made up front.
+ */
+static void init_job(job_t *job, test_ptr t)
+{
+    int args = t->args;    /* number of function arguments */
+    int arg_test_range[3]; /* test range for each argument */
+    unsigned seed = 1 + 3 * (t - test_set); /* seeds of its streams */
+    int i, calls;
+    gen_t g;
+
+    /* Sanity check on the number of args */
+    if (args < 0 || args > 3) {
+	printf("Configuration error: invalid number of args (%d) for function %s\n", args, t->name);
+	exit(1);
+    }
+
+    /* Assign range of argument test vals so as to conserve the total
+       number of tests, independent of the number of arguments */
+    arg_test_range[0] = arg_test_range[1] = arg_test_range[2] = 1;
+    if (args == 1) {
+	arg_test_range[0] = TEST_RANGE;
+    }
+    else if (args == 2) {
+	arg_test_range[0] = pow((double)TEST_RANGE, 0.5);  /* sqrt */
+	arg_test_range[1] = arg_test_range[0];
+    }
+    else if (args == 3) {
+	arg_test_range[0] = pow((double)TEST_RANGE, 0.333); /* cbrt */
+	arg_test_range[1] = arg_test_range[0];
+	arg_test_range[2] = arg_test_range[0];
+    }
+
+    /* Sanity check on the ranges */
+    if (arg_test_range[0] < 1)
+	arg_test_range[0] = 1;
+    if (arg_test_range[1] < 1) 
+	arg_test_range[1] = 1;
+    if (arg_test_range[2] < 1) 
+	arg_test_range[2] = 1;
+
+    memset(job, 0, sizeof(*job));
+    job->t = t;
+
+    /* A function with no arguments is called once */
+    job->counts[0] = job->counts[1] = job->counts[2] = 1;
+    job->first.count = 1;
+    calls = 1;
+    for (i = 0; i < args; i++) {
+	if (i == 0) {
+	    gen_init(&job->first, t->arg_ranges[0][0], t->arg_ranges[0][1], 
+		     arg_test_range[0], 0, seed);
+	    job->counts[0] = job->first.count;
+	    continue;
+	}
+	gen_init(&g, t->arg_ranges[i][0], t->arg_ranges[i][1], 
+		 arg_test_range[i], i, seed + i);
+	job->vals[i] = malloc(g.count * sizeof(int));
+	if (job->vals[i] == NULL) {
+	    printf("Out of memory\n");
+	    exit(1);
+	}
+	job->counts[i] = gen_next(&g, job->vals[i], g.count);
+	calls *= job->counts[i];
+    }
+    job->chunk = CHUNK_TESTS / calls > 0 ? CHUNK_TESTS / calls : 1;
+}
+
+/* 
+ * free_job - Free the test values of a job 
+ */
+static void free_job(job_t *job)
+{
+    free(job->vals[1]);
+    free(job->vals[2]);
+    free(job->redo);
+    job->vals[1] = job->vals[2] = NULL;
+    job->redo = NULL;
+}
+
+/* 
+ * test_range - Run the tests of job whose first argument is one of
+ *    its values lo..hi-1, which are in first[0..hi-lo-1], in order, 
+ *    until one fails. Return the number of errors (0 or 1) and 
+ *    describe the failure in fail.
+ */
+static int test_range(job_t *job, int *first, int lo, int hi, fail_t *fail)
+{
+    test_ptr t = job->t;
+    int args = t->args;    /* number of function arguments */
+    int a1, a2, a3;        
+    batch_t b;
+
+    /* Test function has no arguments */
+    if (args == 0) {
+	fail->found = test_0_arg(t->solution_funct, t->test_funct, fail);
+	fail->index = 0;
+	return fail->found;
+    } 
+
+    /* 
+     * Test function has at least one argument. Collect the argument
+     * values in batches, in the order of the nested loops.
+     */
+    fail->found = 0;
+    b.n = 0;
+    for (a1 = lo; a1 < hi; a1++) {
+	for (a2 = 0; a2 < job->counts[1]; a2++) {
+	    for (a3 = 0; a3 < job->counts[2]; a3++) {
+		b.index[b.n] = a1;
+		b.args[0][b.n] = first[a1 - lo];
+		b.args[1][b.n] = args > 1 ? job->vals[1][a2] : 0;
+		b.args[2][b.n] = args > 2 ? job->vals[2][a3] : 0;
+		/* Stop testing if there is an error */
+		if (++b.n == BATCH_TESTS && check_batch(t, &b, fail))
+		    return 1;
+	    } /* a3 */
+	} /* a2 */
+    } /* a1 */
+
+    if (b.n > 0 && check_batch(t, &b, fail))
+	return 1;
+    return 0;
+}
+
+/* 
+ * find_failure - Run all the tests of job, a chunk of the first
+ *    argument's values at a time, until one fails. Return the number
+ *    of errors (0 or 1) and describe the failure in fail.
+ */
+static int find_failure(job_t *job, fail_t *fail)
+{
+    static int first[CHUNK_TESTS];
+    int lo, n;
+
+    for (lo = 0; lo < job->counts[0]; lo += n) {
+	n = job->t->args > 0 ? gen_next(&job->first, first, job->chunk) : 1;
+	if (test_range(job, first, lo, lo + n, fail))
+	    return 1;
+    }
+    return 0;
+}
+
+/* 
+ * test_function - Test a function.  Return number of errors 
+ */
+static int test_function(test_ptr t) {
+    int errors = 0;
+    fail_t fail;
+
+    /* The job is static so that it survives the longjmp of a timeout */
+    static job_t job;
+
+    init_job(&job, t);
+
+    /* Handle timeouts in the test code */
+    if (timeout_limit > 0) {
+	int rc;
+	rc = sigsetjmp(envbuf, 1);
+	if (rc) {
+	    /* control will reach here if there is a timeout */
+	    errors = 1;
+	    printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
+	    free_job(&job);
+	    return errors;
+	}
+	alarm(timeout_limit);
+    }
+
+    errors = find_failure(&job, &fail);
+    if (errors)
+	report_failure(t, &fail);
+    free_job(&job);
+    return errors;
+}
+
+/* Names of the classes, for -c */
+static char *class_names[NUM_CLASSES] = {
+    "single-bit", "all-but-one", "byte", "sign", "zero", "exponent", 
+    "nan", "range", "fixed"
+};
+
+/* The values of the classes, and the class of each */
+static int class_vals[MAX_CLASS_VALS];
+static char class_of[MAX_CLASS_VALS];
+static int num_class_vals = 0;
+
+/* 
+ * add_class_val - Add v to class c, unless some class already has it 
+ */
+static void add_class_val(unsigned v, int c)
+{
+    int i;
+
+    for (i = 0; i < num_class_vals; i++)
+	if (class_vals[i] == (int) v)
+	    return;
+    class_vals[num_class_vals] = v;
+    class_of[num_class_vals++] = c;
+}
+
+/* 
+ * class_table - Return the number of values in the bit-pattern
+ *    classes, and set *valsp and *clsp to the values and the class
+ *    of each one. A value is listed only once, in the first class
+ *    that has it.
+ */
+static int class_table(int **valsp, char **clsp)
+{
+    static int bounds[] = {7, 8, 15, 16, 23, 24, 31};
+    static unsigned signs[] = {0, 1, 2, 0x7ffffffe, 0x7fffffff, 0x3f800000};
+    unsigned e;
+    int i;
+
+    if (num_class_vals == 0) {
+	for (i = 0; i < 32; i++)
+	    add_class_val(1u << i, CLASS_SINGLE);
+	for (i = 0; i < 32; i++)
+	    add_class_val(~(1u << i), CLASS_ALLBUT);
+	for (i = 0; i < 4; i++) {
+	    add_class_val(0xffu << 8*i, CLASS_BYTE);
+	    add_class_val(~(0xffu << 8*i), CLASS_BYTE);
+	}
+	for (i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+	    add_class_val((1u << bounds[i]) - 1, CLASS_BYTE);
+	    add_class_val((1u << bounds[i]) + 1, CLASS_BYTE);
+	}
+	for (i = 0; i < sizeof(signs) / sizeof(signs[0]); i++) {
+	    add_class_val(signs[i], CLASS_SIGN);
+	    add_class_val(signs[i] ^ 0x80000000, CLASS_SIGN);
+	    add_class_val(-signs[i], CLASS_SIGN);
+	}
+	for (i = -16; i <= 16; i++)
+	    add_class_val(i, CLASS_ZERO);
+	for (e = 0; e < 256; e++) {
+	    add_class_val(e << 23, CLASS_EXP);
+	    add_class_val(e << 23 | 0x7fffff, CLASS_EXP);
+	    add_class_val(0x80000000 | e << 23, CLASS_EXP);
+	    add_class_val(0x80000000 | e << 23 | 0x7fffff, CLASS_EXP);
+	}
+	for (i = 0; i < 23; i++) {
+	    add_class_val(0x7f800000 | 1u << i, CLASS_NAN);
+	    add_class_val(0xff800000 | 1u << i, CLASS_NAN);
+	    add_class_val(0x7fc00000 | 1u << i, CLASS_NAN);
+	}
+    }
+    *valsp = class_vals;
+    *clsp = class_of;
+    return num_class_vals;
+}
+
+/* 
+ * class_arg - Put the values that argument arg of function t takes
+ *    with -c in vals, and their classes in cls, and return how many
+ *    there are. Small ranges are tested on every value, and others
+ *    on the values of the classes that are in range.
+ */
+static int class_arg(test_ptr t, int arg, int *vals, char *cls)
+{
+    int min = t->arg_ranges[arg][0];
+    int max = t->arg_ranges[arg][1];
+    int *tvals;
+    char *tcls;
+    int i, n, count = 0;
+
+    if (has_arg[arg]) {
+	vals[0] = argval[arg];
+	cls[0] = CLASS_FIXED;
+	return 1;
+    }
+
+    /* Float arguments (see gen_init) are any bit pattern */
+    if (!(min == 1 && max == 1) && (long long) max - min < MAX_RANGE_VALS) {
+	for (i = min; i <= max; i++) {
+	    vals[count] = i;
+	    cls[count++] = CLASS_RANGE;
+	}
+	return count;
+    }
+
+    n = class_table(&tvals, &tcls);
+    for (i = 0; i < n; i++)
+	if ((min == 1 && max == 1) || (tvals[i] >= min && tvals[i] <= max)) {
+	    vals[count] = tvals[i];
+	    cls[count++] = tcls[i];
+	}
+    return count;
+}
+
+/* 
+ * class_index - Set ix to the index of each argument's value in test
+ *    n of the combinations of the counts values of the args arguments
+ */
+static void class_index(int n, int args, int *counts, int *ix)
+{
+    int k;
+
+    for (k = args - 1; k >= 0; k--) {
+	ix[k] = n % counts[k];
+	n /= counts[k];
+    }
+}
+
+/* 
+ * flip_bits - Try the failing test of function t in fail again with
+ *    each bit of each argument flipped in turn, and print which of
+ *    those also fail. Arguments that don't take their values from the
+ *    classes (the flags in wide are clear) are left alone.
+ */
+static void flip_bits(test_ptr t, fail_t *fail, int *wide)
+{
+    static batch_t b;
+    char bits[32 * 3 + 1];
+    int min, max, m, i, k, j;
+
+    for (k = 0; k < t->args; k++) {
+	if (!wide[k])
+	    continue;
+	min = t->arg_ranges[k][0];
+	max = t->arg_ranges[k][1];
+	b.n = 0;
+	for (i = 0; i < 32; i++) {
+	    m = fail->args[k] ^ (1u << i);
+	    if (!(min == 1 && max == 1) && (m < min || m > max))
+		continue;
+	    for (j = 0; j < t->args; j++)
+		b.args[j][b.n] = fail->args[j];
+	    b.args[k][b.n] = m;
+	    b.index[b.n++] = i;
+	}
+	run_batch(t, &b);
+
+	bits[0] = '\0';
+	for (i = 0; i < b.n; i++)
+	    if (b.r[i] != b.rt[i])
+		sprintf(bits + strlen(bits), " %d", b.index[i]);
+	if (bits[0])
+	    printf("...Also fails with bit(s)%s of arg %d flipped\n", 
+		   bits, k + 1);
+	else
+	    printf("...Passes with any one bit of arg %d flipped\n", k + 1);
+    }
+}
+
+/* 
+ * class_test - Test function t on every combination of the values
+ *    its arguments take with -c (see class_arg). Print how many of
+ *    the values of each class were used and how many of the failing
+ *    tests had an argument of each class, and try flipping each bit
+ *    of the arguments of the first failure. Return the number of
+ *    errors (0 or 1).
+ */
+static int class_test(test_ptr t)
+{
+    static int vals[3][MAX_CLASS_VALS];
+    static char cls[3][MAX_CLASS_VALS];
+    static batch_t b;
+    int counts[3] = {1, 1, 1};
+    int wide[3] = {0, 0, 0};
+    int used[NUM_CLASSES], total[NUM_CLASSES], failed[NUM_CLASSES];
+    int ix[3];
+    int *tvals;
+    char *tcls;
+    int ntable, calls, failures = 0;
+    unsigned mask;
+    int i, k, c, n;
+    fail_t fail;
+
+    if (t->args == 0)
+	return test_function(t);
+
+    /* Handle timeouts in the test code */
+    if (timeout_limit > 0) {
+	int rc;
+	rc = sigsetjmp(envbuf, 1);
+	if (rc) {
+	    /* control will reach here if there is a timeout */
+	    printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
+	    return 1;
+	}
+	alarm(timeout_limit);
+    }
+
+    memset(used, 0, sizeof(used));
+    memset(total, 0, sizeof(total));
+    memset(failed, 0, sizeof(failed));
+    memset(&fail, 0, sizeof(fail));
+    ntable = class_table(&tvals, &tcls);
+    calls = 1;
+    for (k = 0; k < t->args; k++) {
+	counts[k] = class_arg(t, k, vals[k], cls[k]);
+	calls *= counts[k];
+	for (i = 0; i < counts[k]; i++)
+	    used[(int) cls[k][i]]++;
+	if (cls[k][0] == CLASS_RANGE || cls[k][0] == CLASS_FIXED)
+	    total[(int) cls[k][0]] += counts[k];
+	else {
+	    wide[k] = 1;
+	    for (i = 0; i < ntable; i++)
+		total[(int) tcls[i]]++;
+	}
+    }
+
+    /* Keep going after a failure, to see which classes fail */
+    b.n = 0;
+    for (n = 0; n < calls; n++) {
+	class_index(n, t->args, counts, ix);
+	for (k = 0; k < t->args; k++)
+	    b.args[k][b.n] = vals[k][ix[k]];
+	b.index[b.n++] = n;
+	if (b.n < BATCH_TESTS && n < calls - 1)
+	    continue;
+
+	run_batch(t, &b);
+	for (i = 0; i < b.n; i++) {
+	    if (b.r[i] == b.rt[i])
+		continue;
+	    if (failures++ == 0) {
+		fail.found = 1;
+		fail.index = b.index[i];
+		for (k = 0; k < t->args; k++)
+		    fail.args[k] = b.args[k][i];
+		fail.r = b.r[i];
+		fail.rt = b.rt[i];
+	    }
+	    class_index(b.index[i], t->args, counts, ix);
+	    mask = 0;
+	    for (k = 0; k < t->args; k++)
+		mask |= 1u << cls[k][ix[k]];
+	    for (c = 0; c < NUM_CLASSES; c++)
+		if (mask & (1u << c))
+		    failed[c]++;
+	}
+	b.n = 0;
+    }
+
+    if (failures) {
+	report_failure(t, &fail);
+	if (!grade) {
+	    printf("...%d of %d tests failed\n", failures, calls);
+	    flip_bits(t, &fail, wide);
+	}
+    }
+    if (!grade) {
+	printf("Classes of %s:", t->name);
+	for (c = 0, k = 0; c < NUM_CLASSES; c++) {
+	    if (total[c] == 0)
+		continue;
+	    printf("%s %s %d/%d", k++ ? "," : "", class_names[c], 
+		   used[c], total[c]);
+	    if (failed[c])
+		printf(" (%d failed)", failed[c]);
+	}
+	printf("\n");
+    }
+    return failures > 0;
+}
+
+/* 
+ * xorshift - Return the next value of the xorshift32 generator with
+ *    state *s, which must not be 0
+ */
+static unsigned xorshift(unsigned *s)
+{
+    unsigned x = *s;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/* 
+ * fuzz_arg - Map v into the range of argument k of function t 
+ */
+static int fuzz_arg(test_ptr t, int k, unsigned v)
+{
+    int min = t->arg_ranges[k][0];
+    int max = t->arg_ranges[k][1];
+    unsigned span = (unsigned) max - (unsigned) min + 1;
+
+    if (has_arg[k])
+	return argval[k];
+    if ((min == 1 && max == 1) || span == 0)
+	return v;
+    return min + v % span;
+}
+
+/* 
+ * mutate - Put a mutation of the arguments in in of function t into
+ *    out, changing one argument in one of several ways
+ */
+static void mutate(test_ptr t, int *in, int *out, unsigned *seed)
+{
+    static unsigned bytes[] = {0x00, 0x7f, 0x80, 0xff};
+    unsigned r = xorshift(seed);
+    int k = (r >> 8) % t->args;
+    unsigned v;
+    int i, j;
+
+    for (i = 0; i < t->args; i++)
+	out[i] = in[i];
+    v = in[k];
+    switch (r & 7) {
+    case 0: /* flip a bit */
+	v ^= 1u << (xorshift(seed) & 31);
+	break;
+    case 1: /* flip two bits */
+	v ^= 1u << (xorshift(seed) & 31);
+	v ^= 1u << (xorshift(seed) & 31);
+	break;
+    case 2: /* set a byte to a special or random value */
+	i = xorshift(seed);
+	j = 8 * (i & 3);
+	v = (v & ~(0xffu << j)) | 
+	    ((i & 4 ? bytes[(i >> 3) & 3] : (i >> 8) & 0xff) << j);
+	break;
+    case 3: /* add a small value */
+	v += (int) (xorshift(seed) % 33) - 16;
+	break;
+    case 4: /* negate or complement */
+	v = xorshift(seed) & 1 ? -v : ~v;
+	break;
+    case 5: /* anything at all */
+	v = xorshift(seed);
+	break;
+    case 6: /* set the exponent of a float to 0, 255, or anything */
+	i = xorshift(seed);
+	j = (i & 3) == 0 ? 0 : (i & 3) == 1 ? 255 : (i >> 2) & 0xff;
+	v = (v & ~0x7f800000u) | (unsigned) j << 23;
+	break;
+    default: /* copy another argument, or shift */
+	i = xorshift(seed);
+	if (t->args > 1)
+	    v = in[i % t->args];
+	else
+	    v = i & 32 ? v << (i & 31) : v >> (i & 31);
+	break;
+    }
+    out[k] = fuzz_arg(t, k, v);
+}
+
+/* 
+ * result_kind - Return which of the FUZZ_KINDS kinds of results r
+ *    is, by its number of leading zeros and of ones
+ */
+static int result_kind(int r)
+{
+    unsigned u = r;
+
+    return (u ? __builtin_clz(u) : 32) * 33 + __builtin_popcount(u);
+}
+
+/* 
+ * save_input - Append the arguments a of function t to the corpus
+ *    file fp, with a comment if the test failed (r != rt)
+ */
+static void save_input(FILE *fp, test_ptr t, int *a, int r, int rt)
+{
+    int k;
+
+    if (fp == NULL)
+	return;
+    for (k = 0; k < t->args; k++)
+	fprintf(fp, "%s0x%x", k ? " " : "", a[k]);
+    if (r != rt)
+	fprintf(fp, " # fails: gives 0x%x, should be 0x%x", r, rt);
+    fprintf(fp, "\n");
+    fflush(fp);
+}
+
+/* 
+ * replay_batch - Run the tests in batch b of function t, which come
+ *    from its corpus, and empty it. Mark the kinds of results of the
+ *    tests that pass as seen, and return the number of errors (0 or
+ *    1), describing the failure in fail.
+ */
+static int replay_batch(test_ptr t, batch_t *b, char *seen, fail_t *fail)
+{
+    int i, k;
+
+    run_batch(t, b);
+    i = first_mismatch(b->r, b->rt, b->n);
+    for (k = 0; k < i; k++)
+	seen[result_kind(b->rt[k])] = 1;
+    if (i < b->n) {
+	fail->found = 1;
+	fail->index = b->index[i];
+	for (k = 0; k < t->args; k++)
+	    fail->args[k] = b->args[k][i];
+	fail->r = b->r[i];
+	fail->rt = b->rt[i];
+    }
+    b->n = 0;
+    return fail->found;
+}
+
+/* 
+ * fuzz_test - Test function t on the inputs in its corpus file in
+ *    the -D directory, if there is one, and then on mutations of
+ *    them for fuzz_secs seconds, until a test fails. Inputs that fail
+ *    or give a kind of result (see result_kind) that wasn't seen
+ *    before are added to the corpus. Return the number of errors (0
+ *    or 1).
+ */
+static int fuzz_test(test_ptr t)
+{
+    static int corpus[FUZZ_CORPUS][3];
+    static char seen[FUZZ_KINDS];
+    static int vals[3][MAX_CLASS_VALS];
+    static char cls[3][MAX_CLASS_VALS];
+    static batch_t b;
+    static FILE *fp;
+    char path[1024], line[256];
+    int counts[3], a[3];
+    int ncorpus = 0, nsaved = 0, nold, lineno = 0;
+    unsigned seed;
+    long long tests = 0;
+    struct timespec start, now;
+    double secs;
+    fail_t fail;
+    int i, k, n;
+
+    if (t->args == 0)
+	return test_function(t);
+
+    /* Handle timeouts in the test code */
+    fp = NULL;
+    if (timeout_limit > 0) {
+	int rc;
+	rc = sigsetjmp(envbuf, 1);
+	if (rc) {
+	    /* control will reach here if there is a timeout */
+	    printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
+	    if (fp)
+		fclose(fp);
+	    return 1;
+	}
+	alarm(timeout_limit);
+    }
+
+    memset(seen, 0, sizeof(seen));
+    memset(&fail, 0, sizeof(fail));
+
+    /* Replay the corpus, one line of arguments per input */
+    if (corpus_dir) {
+	snprintf(path, sizeof(path), "%s/%s", corpus_dir, t->name);
+	b.n = 0;
+	fp = fopen(path, "r");
+	while (fp && !fail.found && fgets(line, sizeof(line), fp)) {
+	    lineno++;
+	    if (sscanf(line, "%i %i %i", &a[0], &a[1], &a[2]) < t->args)
+		continue;
+	    for (k = 0; k < t->args; k++)
+		b.args[k][b.n] = a[k];
+	    b.index[b.n] = lineno;
+	    if (ncorpus < FUZZ_CORPUS)
+		memcpy(corpus[ncorpus], a, sizeof(a));
+	    ncorpus++;
+	    if (++b.n == BATCH_TESTS)
+		replay_batch(t, &b, seen, &fail);
+	}
+	if (fp)
+	    fclose(fp);
+	fp = NULL;
+	if (!fail.found && b.n > 0)
+	    replay_batch(t, &b, seen, &fail);
+	if (fail.found) {
+	    report_failure(t, &fail);
+	    if (!grade)
+		printf("...Line %d of %s\n", fail.index, path);
+	    return 1;
+	}
+	if (ncorpus > FUZZ_CORPUS)
+	    ncorpus = FUZZ_CORPUS;
+
+	mkdir(corpus_dir, 0777);
+	fp = fopen(path, "a");
+	if (fp == NULL)
+	    fprintf(stderr, "Warning: can't write corpus file %s\n", path);
+    }
+
+    /* Add some of the class values (see class_arg) to a small corpus */
+    seed = fuzz_seed ^ (t - test_set) << 24;
+    if (seed == 0)
+	seed = 1;
+    for (k = 0; k < t->args; k++)
+	counts[k] = class_arg(t, k, vals[k], cls[k]);
+    for (; ncorpus < FUZZ_SEEDS; ncorpus++)
+	for (k = 0; k < t->args; k++)
+	    corpus[ncorpus][k] = vals[k][xorshift(&seed) % counts[k]];
+    nold = ncorpus;
+
+    /* Mutate a batch of inputs at a time, until one fails or time is
+       up. The alarm is restarted for each batch. */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+	if (timeout_limit > 0)
+	    alarm(timeout_limit);
+	for (n = 0; n < BATCH_TESTS; n++) {
+	    mutate(t, corpus[xorshift(&seed) % ncorpus], a, &seed);
+	    for (k = 0; k < t->args; k++)
+		b.args[k][n] = a[k];
+	    b.index[n] = tests + n;
+	}
+	b.n = n;
+	run_batch(t, &b);
+	i = first_mismatch(b.r, b.rt, b.n);
+	for (n = 0; n < i; n++) {
+	    int kind = result_kind(b.rt[n]);
+
+	    if (seen[kind])
+		continue;
+	    seen[kind] = 1;
+	    if (ncorpus < FUZZ_CORPUS) {
+		for (k = 0; k < t->args; k++)
+		    corpus[ncorpus][k] = b.args[k][n];
+		save_input(fp, t, corpus[ncorpus++], 0, 0);
+		nsaved++;
+	    }
+	}
+	tests += i;
+	if (i < b.n) {
+	    fail.found = 1;
+	    fail.index = b.index[i];
+	    for (k = 0; k < t->args; k++)
+		fail.args[k] = b.args[k][i];
+	    fail.r = b.r[i];
+	    fail.rt = b.rt[i];
+	    save_input(fp, t, fail.args, fail.r, fail.rt);
+	    tests++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	secs = (now.tv_sec - start.tv_sec) + 
+	    (now.tv_nsec - start.tv_nsec) / 1e9;
+    } while (!fail.found && secs < fuzz_secs);
+    alarm(0);
+    if (fp)
+	fclose(fp);
+
+    if (fail.found)
+	report_failure(t, &fail);
+    if (!grade)
+	printf("Fuzzed %s: %lld tests in %.1f secs (%.1fM/sec), %d inputs "
+	       "in corpus, %d new, seed %u\n", t->name, tests, secs, 
+	       secs > 0 ? tests / secs / 1e6 : 0.0, nold + nsaved, nsaved,
+	       fuzz_seed);
+    return fail.found;
+}
+
+/* 
+ * can_sweep - Return true if function t can be checked on every
+ *    input with -e: it has one argument, which can be any int or the
+ *    bits of any float, and which wasn't given with -1
+ */
+static int can_sweep(test_ptr t)
+{
+    return t->args == 1 && !has_arg[0] &&
+	((t->arg_ranges[0][0] == INT_MIN && t->arg_ranges[0][1] == INT_MAX) ||
+	 (t->arg_ranges[0][0] == 1 && t->arg_ranges[0][1] == 1));
+}
+
+/* 
+ * sweep_range - Check a one-argument function on every input in
+ *    blocks lo..hi-1 of SWEEP_BLOCK inputs, in order, until one fails.
+ *    Return the number of errors (0 or 1) and describe the failure in
+ *    fail.
+ */
+static int sweep_range(test_ptr t, int lo, int hi, fail_t *fail)
+{
+    funct1_t f1 = (funct1_t) t->solution_funct;
+    funct1_t f1t = (funct1_t) t->test_funct;
+    batch_rec *bt = batch_refs[t - test_set];
+    int x[SWEEP_BLOCK], r[SWEEP_BLOCK], rt[SWEEP_BLOCK];
+    int b, i;
+    unsigned base;
+
+    for (b = lo; b < hi; b++) {
+	base = (unsigned) b * SWEEP_BLOCK;
+	for (i = 0; i < SWEEP_BLOCK; i++)
+	    x[i] = base + i;
+	for (i = 0; i < SWEEP_BLOCK; i++)
+	    r[i] = f1(x[i]);
+	if (bt)
+	    bt->batch1(x, rt, SWEEP_BLOCK);
+	else
+	    for (i = 0; i < SWEEP_BLOCK; i++)
+		rt[i] = f1t(x[i]);
+
+	if ((i = first_mismatch(r, rt, SWEEP_BLOCK)) == SWEEP_BLOCK)
+	    continue;
+	fail->found = 1;
+	fail->index = b;
+	fail->args[0] = base + i;
+	fail->r = r[i];
+	fail->rt = rt[i];
+	return 1;
+    }
+    fail->found = 0;
+    return 0;
+}
+
+/*****************************************************
+ * Testing with a pool of worker threads (-j)
+ *
+ * Every function to be tested becomes a job, and the values of its
+ * first argument are handed out to the workers in chunks, so that
+ * a long function is split across the threads and the next function
+ * is started while the last chunks of the previous one are running.
+ * Each work item records its own first failure; the job keeps the
+ * one with the lowest first-argument index, which is the failure a
+ * sequential run would have reported. Chunks past a known failure
+ * are skipped.
+ *
+ * A timeout can't longjmp out of another thread, so the workers run
+ * the tests with asynchronous cancellation enabled. The time limit
+ * applies to each work item, which lets an exhaustive sweep (-e) take
+ * longer than the limit. If a work item runs past its deadline, the
+ * main thread cancels all of the workers, marks its job as timed out,
+ * and starts a new set of workers. The work items that the other
+ * workers were running are handed out again, so only their tests are
+ * repeated.
+ *****************************************************/
+
+/*
+ * job_check - Mark the values of job past its first failure as done,
+ *    and wake up the main thread if nothing is left to do. Called with
+ *    job_lock held.
+ */
+static void job_check(job_t *job)
+{
+    int i;
+
+    if (job->fail.found && job->next > job->fail.index) {
+	job->finished += job->counts[0] - job->next;
+	job->next = job->counts[0];
+    }
+    for (i = 0; job->fail.found && i < job->nredo; ) {
+	if (job->redo[i].lo > job->fail.index) {
+	    job->finished += job->redo[i].hi - job->redo[i].lo;
+	    job->redo[i] = job->redo[--job->nredo];
+	}
+	else
+	    i++;
+    }
+    if (job->finished == job->counts[0])
+	pthread_cond_broadcast(&job_event);
+}
+
+/*
+ * timespec_passed - Return true if time a is at or after time b
+ */
+static int timespec_passed(struct timespec *a, struct timespec *b)
+{
+    return a->tv_sec > b->tv_sec || 
+	(a->tv_sec == b->tv_sec && a->tv_nsec >= b->tv_nsec);
+}
+
+/*
+ * worker - Run work items until no job has any left. arg is the
+ *    thread's slot.
+ */
+static void *worker(void *arg)
+{
+    slot_t *slot = (slot_t *) arg;
+    item_t *item = &slot->item;
+    job_t *job = NULL;
+    fail_t fail;
+    gen_t g;
+    int j, lo, hi;
+    int first[CHUNK_TESTS];  /* the first-argument values of a work item */
+
+    pthread_mutex_lock(&job_lock);
+    for (;;) {
+	/* Take the next chunk of the first job that has one */
+	for (j = 0; j < num_jobs; j++) {
+	    job = &jobs[j];
+	    job_check(job);
+	    if (!job->timed_out && 
+		(job->nredo > 0 || job->next < job->counts[0]))
+		break;
+	}
+	if (j == num_jobs)
+	    break;
+	slot->job = job;
+	clock_gettime(CLOCK_REALTIME, &slot->deadline);
+	slot->deadline.tv_sec += timeout_limit;
+	pthread_cond_broadcast(&job_event); /* a new deadline to watch */
+	if (job->nredo > 0) {
+	    /* One that was cancelled by restart_workers */
+	    *item = job->redo[--job->nredo];
+	    lo = item->lo;
+	    hi = item->hi;
+	    g = item->first;
+	    if (!job->sweep && job->t->args > 0)
+		gen_next(&g, first, hi - lo);
+	}
+	else {
+	    lo = job->next;
+	    item->first = job->first;
+	    if (job->sweep || job->t->args == 0)
+		hi = lo + job->chunk < job->counts[0] ? 
+		    lo + job->chunk : job->counts[0];
+	    else
+		hi = lo + gen_next(&job->first, first, job->chunk);
+	    job->next = hi;
+	    item->lo = lo;
+	    item->hi = hi;
+	}
+	pthread_mutex_unlock(&job_lock);
+
+	/* The tests may loop forever, so let them be cancelled anywhere */
+	pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
+	if (job->sweep)
+	    sweep_range(job->t, lo, hi, &fail);
+	else
+	    test_range(job, first, lo, hi, &fail);
+	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
+
+	pthread_mutex_lock(&job_lock);
+	slot->job = NULL;
+	if (fail.found && (!job->fail.found || fail.index < job->fail.index))
+	    job->fail = fail;
+	job->finished += hi - lo;
+	job_check(job);
+    }
+    pthread_mutex_unlock(&job_lock);
+    return NULL;
+}
+
+/*
+ * start_workers - Create the worker threads
+ */
+static void start_workers(void)
+{
+    int i;
+
+    for (i = 0; i < num_threads; i++)
+	if (pthread_create(&threads[i], NULL, worker, &slots[i]) != 0) {
+	    printf("Couldn't create worker thread\n");
+	    exit(1);
+	}
+}
+
+/*
+ * start_jobs - Start the streams of test values for each function that
+ *    will be tested, and start the workers on them. The workers take
+ *    the first-argument values from the stream in order, so they are
+ *    the same as in a sequential run. With -e, one-argument functions
+ *    that take any int (or any float) are swept over all inputs 
+ *    instead.
  */
-typedef void handler_t(int);
-
-handler_t *Signal(int signum, handler_t *handler) 
+static void start_jobs(void)
 {
-    struct sigaction action, old_action;
+    job_t *job;
+    int i;
 
-    action.sa_handler = handler;  
-    sigemptyset(&action.sa_mask); /* block sigs of type being handled */
-    action.sa_flags = SA_RESTART; /* restart syscalls if possible */
+    for (i = 0; test_set[i].solution_funct; i++)
+	;
+    jobs = calloc(i, sizeof(job_t));
+    threads = calloc(num_threads, sizeof(pthread_t));
+    slots = calloc(num_threads, sizeof(slot_t));
+    if (jobs == NULL || threads == NULL || slots == NULL) {
+	printf("Out of memory\n");
+	exit(1);
+    }
 
-    if (sigaction(signum, &action, &old_action) < 0)
-	perror("Signal error");
-    return (old_action.sa_handler);
+    for (i = 0; test_set[i].solution_funct; i++) {
+	if (test_fname && strcmp(test_set[i].name, test_fname) != 0)
+	    continue;
+	job = &jobs[num_jobs++];
+	init_job(job, &test_set[i]);
+	if ((job->redo = calloc(num_threads, sizeof(item_t))) == NULL) {
+	    printf("Out of memory\n");
+	    exit(1);
+	}
+	if (exhaustive && can_sweep(job->t)) {
+	    job->sweep = 1;
+	    job->counts[0] = SWEEP_BLOCKS;
+	    job->chunk = CHUNK_TESTS / SWEEP_BLOCK;
+	}
+    }
+    start_workers();
 }
 
-/* 
- * timeout_handler - SIGALARM hander 
+/*
+ * restart_workers - Cancel the workers after a work item timed out.
+ *    The jobs of work items that ran past their deadline are marked as
+ *    timed out, and the other work items that were under way are put
+ *    back to be run again. Called with job_lock held.
  */
-sigjmp_buf envbuf;
-void timeout_handler(int sig) {
-    siglongjmp(envbuf, 1);
+static void restart_workers(void)
+{
+    struct timespec now;
+    job_t *job;
+    int i;
+
+    pthread_mutex_unlock(&job_lock);
+    for (i = 0; i < num_threads; i++)
+	pthread_cancel(threads[i]);
+    for (i = 0; i < num_threads; i++)
+	pthread_join(threads[i], NULL);
+    pthread_mutex_lock(&job_lock);
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    for (i = 0; i < num_threads; i++) {
+	if ((job = slots[i].job) == NULL)
+	    continue;
+	if (timespec_passed(&now, &slots[i].deadline))
+	    job->timed_out = 1;
+	else
+	    job->redo[job->nredo++] = slots[i].item;
+	slots[i].job = NULL;
+    }
+    start_workers();
 }
 
-/* 
- * random_val - Return random integer value between min and max 
+/*
+ * earliest_deadline - Return the earliest deadline of the running work
+ *    items, or NULL if there are none (or no time limit). Called with
+ *    job_lock held.
  */
-static int random_val(int min, int max)
+static struct timespec *earliest_deadline(void)
 {
-    double weight = rand()/(double) RAND_MAX;
-    int result = min * (1-weight) + max * weight;
-    return result;
+    struct timespec *deadline = NULL;
+    int i;
+
+    for (i = 0; i < num_threads; i++)
+	if (timeout_limit > 0 && slots[i].job &&
+	    (deadline == NULL || 
+	     !timespec_passed(&slots[i].deadline, deadline)))
+	    deadline = &slots[i].deadline;
+    return deadline;
 }
 
-/* 
- * gen_vals - Generate the integer values we'll use to test a function 
+/*
+ * wait_job - Wait for the tests of job j to finish and report them
+ *    like test_function does.  Return number of errors 
  */
-static int gen_vals(int test_vals[], int min, int max, int test_range, int arg)
+static int wait_job(int j)
 {
-    int i;
-    int test_count = 0;
+    job_t *job = &jobs[j];
+    struct timespec *deadline, now;
+    int rc, errors;
+
+    pthread_mutex_lock(&job_lock);
+    while (!job->timed_out && job->finished < job->counts[0]) {
+	/* Sleep until the earliest deadline of the running work items */
+	if ((deadline = earliest_deadline()) == NULL) {
+	    pthread_cond_wait(&job_event, &job_lock);
+	    continue;
+	}
+	rc = pthread_cond_timedwait(&job_event, &job_lock, deadline);
+	if (rc != ETIMEDOUT)
+	    continue;
+
+	/* The work item we slept for may have finished meanwhile */
+	clock_gettime(CLOCK_REALTIME, &now);
+	if ((deadline = earliest_deadline()) != NULL && 
+	    timespec_passed(&now, deadline))
+	    restart_workers();
+    }
+    pthread_mutex_unlock(&job_lock);
 
-    /* Special case: If the user has specified a specific function
-       argument using the -1, -2, or -3 flags, then simply use this
-       argument and return */
-    if (has_arg[arg]) {
-	test_vals[0] = argval[arg];
+    if (job->timed_out) {
+	printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", job->t->name, timeout_limit);
 	return 1;
     }
+    errors = job->fail.found;
+    if (errors)
+	report_failure(job->t, &job->fail);
+    free_job(job);
+    return errors;
+}
 
-    /* 
-     * Special case: Generate test vals for floating point functions
-     * where the input argument is an unsigned bit-level
-     * representation of a float. For this case we want to test the
-     * regions around zero, the smallest normalized and largest
-     * denormalized numbers, one, and the largest normalized number,
-     * as well as inf and nan.
-     */
-    if ((min == 1 && max == 1)) { 
-	unsigned smallest_norm = 0x00800000;
-	unsigned one = 0x3f800000;
-	unsigned largest_norm = 0x7f000000;
-	
-	unsigned inf = 0x7f800000;
-	unsigned nan =  0x7fc00000;
-	unsigned sign = 0x80000000;
-
-	/* Test range should be at most 1/2 the range of one exponent
-	   value */
-	if (test_range > (1 << 23)) {
-	    test_range = 1 << 23;
-	}
-	
-	/* Functions where the input argument is an unsigned bit-level
-	   representation of a float. The number of tests generated
-	   inside this loop body is the value k referenced in the
-	   comment for the global variable MAX_TEST_VALS. */
-
-	for (i = 0; i < test_range; i++) {
-	    /* Denorms around zero */
-	    test_vals[test_count++] = i; 
-	    test_vals[test_count++] = sign | i;
-	    
-	    /* Region around norm to denorm transition */
-	    test_vals[test_count++] = smallest_norm + i;
-	    test_vals[test_count++] = smallest_norm - i;
-	    test_vals[test_count++] = sign | (smallest_norm + i);
-	    test_vals[test_count++] = sign | (smallest_norm - i);
-	    
-	    /* Region around one */
-	    test_vals[test_count++] = one + i;
-	    test_vals[test_count++] = one - i;
-	    test_vals[test_count++] = sign | (one + i);
-	    test_vals[test_count++] = sign | (one - i);
-	    
-	    /* Region below largest norm */
-	    test_vals[test_count++] = largest_norm - i; 
-	    test_vals[test_count++] = sign | (largest_norm - i); 
-	}
-	
-	/* special vals */
-	test_vals[test_count++] = inf;        /* inf */
-	test_vals[test_count++] = sign | inf; /* -inf */
-	test_vals[test_count++] = nan;        /* nan */
-	test_vals[test_count++] = sign | nan; /* -nan */
-
-	return test_count;
+/* 
+ * iso_run - Run the tests of job j in a worker process of the
+ *    isolation pool, putting the first failure in its shared result
+ */
+static void iso_run(int j)
+{
+    test_ptr t = iso_jobs[j].t;
+    fail_t *fail = &iso_results[j].fail;
+    job_t job;
+
+    memset(fail, 0, sizeof(*fail));
+    if (iso_jobs[j].lo >= 0) {
+	sweep_range(t, iso_jobs[j].lo, iso_jobs[j].hi, fail);
+	return;
     }
+    init_job(&job, t);
+    find_failure(&job, fail);
+    free_job(&job);
+}
 
+/* 
+ * spawn_proc - Start worker process p of the isolation pool. It runs
+ *    the job numbers that it reads from its cmd pipe, and writes a
+ *    byte to its done pipe after each one.
+ */
+static void spawn_proc(proc_t *p)
+{
+    int cmd[2], done[2];
+    int i, j;
 
-    /*
-     * Normal case: Generate test vals for integer functions
-     */
-
-    /* If the range is small enough, then do exhaustively */
-    if (max - MAX_TEST_VALS <= min) {
-	for (i = min; i <= max; i++)
-	    test_vals[test_count++] = i;
-	return test_count;
+    if (pipe(cmd) < 0 || pipe(done) < 0) {
+	perror("pipe");
+	exit(1);
+    }
+    fflush(stdout);
+    p->pid = fork();
+    if (p->pid < 0) {
+	perror("fork");
+	exit(1);
     }
 
-    /* Otherwise, need to sample.  Do so near the boundaries, around
-       zero, and for some random cases. */
-    for (i = 0; i < test_range; i++) {
+    if (p->pid == 0) {
+	/* Keep only our own pipes open, so that each worker sees end
+	   of file when btest exits */
+	for (i = 0; i < num_procs; i++)
+	    if (&procs[i] != p && procs[i].pid > 0) {
+		close(procs[i].cmd);
+		close(procs[i].done);
+	    }
+	close(cmd[1]);
+	close(done[0]);
+	while (read(cmd[0], &j, sizeof(j)) == sizeof(j)) {
+	    iso_run(j);
+	    if (write(done[1], "", 1) != 1)
+		break;
+	}
+	_exit(0);
+    }
 
-	/* Test around the boundaries */
-	test_vals[test_count++] = min + i;
-	test_vals[test_count++] = max - i;
+    close(cmd[0]);
+    close(done[1]);
+    p->cmd = cmd[1];
+    p->done = done[0];
+    p->job = -1;
+}
 
-	/* If zero falls between min and max, then also test around zero */
-	if (i >= min && i <= max)
-	    test_vals[test_count++] = i;
-	if (-i >= min && -i <= max)
-	    test_vals[test_count++] = -i;
+/* 
+ * reap_proc - Wait for worker process p, which died or was killed
+ *    while running its job, and record how that job ended. The
+ *    worker is started again the next time it is given a job.
+ */
+static void reap_proc(proc_t *p, int state)
+{
+    int status;
+
+    waitpid(p->pid, &status, 0);
+    close(p->cmd);
+    close(p->done);
+    p->pid = 0;
+    if (p->job < 0)
+	return;
+    iso_results[p->job].state = state;
+    if (state == ISO_CRASHED)
+	iso_results[p->job].status = status;
+    p->job = -1;
+}
 
-	/* Random case between min and max */
-	test_vals[test_count++] = random_val(min, max);
+/* 
+ * dispatch_jobs - Give the jobs not handed out yet to the idle worker
+ *    processes, starting (or restarting) them as needed
+ */
+static void dispatch_jobs(void)
+{
+    proc_t *p;
+    int i;
 
+    for (i = 0; i < num_procs; i++) {
+	while (iso_next < iso_count && iso_results[iso_next].state != ISO_WAITING)
+	    iso_next++;
+	if (iso_next == iso_count)
+	    break;
+	p = &procs[i];
+	if (p->pid > 0 && p->job >= 0)
+	    continue;
+	if (p->pid == 0)
+	    spawn_proc(p);
+	if (write(p->cmd, &iso_next, sizeof(iso_next)) != sizeof(iso_next)) {
+	    kill(p->pid, SIGKILL);
+	    reap_proc(p, ISO_DONE);
+	    continue;
+	}
+	p->job = iso_next++;
+	clock_gettime(CLOCK_MONOTONIC, &p->started);
     }
-    return test_count;
 }
 
 /* 
- * test_0_arg - Test a function with zero arguments 
+ * elapsed_ms - Return the milliseconds since *start 
  */
-static int test_0_arg(funct_t f, funct_t ft, char *name)
+static long elapsed_ms(struct timespec *start)
 {
-    int r = f();
-    int rt = ft();
-    int error =  (r != rt);
-
-    if (error && !grade)
-	printf("ERROR: Test %s() failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, r, r, rt, rt);
+    struct timespec now;
 
-    return error;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000 + 
+	(now.tv_nsec - start->tv_nsec) / 1000000;
 }
 
 /* 
- * test_1_arg - Test a function with one argument 
+ * start_isolated - Start the isolation pool (-p) on the functions
+ *    to be tested
  */
-static int test_1_arg(funct_t f, funct_t ft, int arg1, char *name)
+static void start_isolated(void)
 {
-    funct1_t f1 = (funct1_t) f;
-    funct1_t f1t = (funct1_t) ft;
-    int r, rt, error;
+    int i, n, lo, f = 0;
+
+    for (i = n = 0; test_set[i].solution_funct; i++)
+	n += exhaustive && can_sweep(&test_set[i]) ? 
+	    SWEEP_BLOCKS / ISO_SWEEP_BLOCKS : 1;
+    iso_jobs = calloc(n, sizeof(iso_job_t));
+    iso_first = calloc(i + 1, sizeof(int));
+    procs = calloc(num_procs, sizeof(proc_t));
+    iso_fds = calloc(num_procs, sizeof(struct pollfd));
+    iso_busy = calloc(num_procs, sizeof(proc_t *));
+    iso_results = mmap(NULL, n * sizeof(iso_result_t), 
+		       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, 
+		       -1, 0);
+    if (iso_jobs == NULL || iso_first == NULL || procs == NULL || iso_fds == NULL ||
+	iso_busy == NULL || iso_results == MAP_FAILED) {
+	printf("Out of memory\n");
+	exit(1);
+    }
+    memset(iso_results, 0, n * sizeof(iso_result_t));
 
-    r = f1(arg1);
-    rt = f1t(arg1);
-    error = (r != rt);
-    if (error && !grade)
-	printf("ERROR: Test %s(%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, arg1, arg1, r, r, rt, rt);
+    for (i = 0; test_set[i].solution_funct; i++) {
+	if (test_fname && strcmp(test_set[i].name, test_fname) != 0)
+	    continue;
+	iso_first[f++] = iso_count;
+	if (!(exhaustive && can_sweep(&test_set[i]))) {
+	    iso_jobs[iso_count].t = &test_set[i];
+	    iso_jobs[iso_count++].lo = -1;
+	    continue;
+	}
+	for (lo = 0; lo < SWEEP_BLOCKS; lo += ISO_SWEEP_BLOCKS) {
+	    iso_jobs[iso_count].t = &test_set[i];
+	    iso_jobs[iso_count].lo = lo;
+	    iso_jobs[iso_count++].hi = lo + ISO_SWEEP_BLOCKS;
+	}
+    }
+    iso_first[f] = iso_count;
 
-    return error;
+    /* A worker that dies makes writes to its pipe fail, not btest */
+    Signal(SIGPIPE, SIG_IGN);
+    for (i = 0; i < num_procs; i++)
+	spawn_proc(&procs[i]);
+    dispatch_jobs();
 }
 
 /* 
- * test_2_arg - Test a function with two arguments 
+ * iso_over - Return the first job of function f of the isolation
+ *    pool that didn't pass, or -1 if they all did, once that is
+ *    known: when it and all the jobs before it have ended. Until
+ *    then, return -2.
  */
-static int test_2_arg(funct_t f, funct_t ft, int arg1, int arg2, char *name)
+static int iso_over(int f)
 {
-    funct2_t f2 = (funct2_t) f;
-    funct2_t f2t = (funct2_t) ft;
-    int r = f2(arg1, arg2);
-    int rt = f2t(arg1, arg2);
-    int error = (r != rt);
+    int j;
 
-    if (error && !grade)
-	printf("ERROR: Test %s(%d[0x%x],%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, arg1, arg1, arg2, arg2, r, r, rt, rt);
-
-    return error;
+    for (j = iso_first[f]; j < iso_first[f + 1]; j++) {
+	if (iso_results[j].state == ISO_WAITING)
+	    return -2;
+	if (iso_results[j].state != ISO_DONE || iso_results[j].fail.found)
+	    return j;
+    }
+    return -1;
 }
 
 /* 
- * test_3_arg - Test a function with three arguments 
+ * wait_isolated - Wait for the jobs of function f of the isolation
+ *    pool to end, while keeping the worker processes busy with the
+ *    others, and report how they went. Return the number of errors
+ *    (0 or 1).
  */
-static int test_3_arg(funct_t f, funct_t ft, 
-		      int arg1, int arg2, int arg3, char *name)
+static int wait_isolated(int f)
 {
-    funct3_t f3 = (funct3_t) f;
-    funct3_t f3t = (funct3_t) ft;
-    int r = f3(arg1, arg2, arg3);
-    int rt = f3t(arg1, arg2, arg3);
-    int error = (r != rt);
+    struct pollfd *fds = iso_fds;
+    proc_t **busy = iso_busy;
+    iso_result_t *res;
+    long wait, left;
+    int i, j, n;
+    char c;
+
+    while ((j = iso_over(f)) == -2) {
+	dispatch_jobs();
+
+	/* Sleep until a worker finishes or dies, or the earliest
+	   deadline */
+	wait = -1;
+	for (i = n = 0; i < num_procs; i++) {
+	    if (procs[i].pid == 0 || procs[i].job < 0)
+		continue;
+	    if (iso_timeout_ms > 0) {
+		left = iso_timeout_ms - elapsed_ms(&procs[i].started);
+		if (left < 0)
+		    left = 0;
+		if (wait < 0 || left < wait)
+		    wait = left;
+	    }
+	    busy[n] = &procs[i];
+	    fds[n].fd = procs[i].done;
+	    fds[n++].events = POLLIN;
+	}
+	if (poll(fds, n, wait) < 0 && errno != EINTR) {
+	    perror("poll");
+	    exit(1);
+	}
 
-    if (error && !grade)
-	printf("ERROR: Test %s(%d[0x%x],%d[0x%x],%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, arg1, arg1, arg2, arg2, arg3, arg3, r, r, rt, rt);
+	for (i = 0; i < n; i++) {
+	    if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+		if (read(busy[i]->done, &c, 1) == 1) {
+		    iso_results[busy[i]->job].state = ISO_DONE;
+		    busy[i]->job = -1;
+		}
+		else
+		    reap_proc(busy[i], ISO_CRASHED);
+	    }
+	    else if (iso_timeout_ms > 0 &&
+		     elapsed_ms(&busy[i]->started) >= iso_timeout_ms) {
+		kill(busy[i]->pid, SIGKILL);
+		reap_proc(busy[i], ISO_TIMED_OUT);
+	    }
+	}
+    }
+    if (j < 0)
+	return 0;
 
-    return error;
+    /* The function's later jobs aren't needed */
+    for (i = j + 1; i < iso_first[f + 1]; i++)
+	if (iso_results[i].state == ISO_WAITING)
+	    iso_results[i].state = ISO_SKIPPED;
+
+    res = &iso_results[j];
+    switch (res->state) {
+    case ISO_TIMED_OUT:
+	if (iso_timeout_ms % 1000 == 0)
+	    printf("ERROR: Test %s failed.\n  Timed out after %ld secs (probably infinite loop)\n", iso_jobs[j].t->name, iso_timeout_ms / 1000);
+	else
+	    printf("ERROR: Test %s failed.\n  Timed out after %ld ms (probably infinite loop)\n", iso_jobs[j].t->name, iso_timeout_ms);
+	break;
+    case ISO_CRASHED:
+	if (WIFSIGNALED(res->status))
+	    printf("ERROR: Test %s failed.\n  Crashed with signal %d (%s)\n", iso_jobs[j].t->name, WTERMSIG(res->status), strsignal(WTERMSIG(res->status)));
+	else
+	    printf("ERROR: Test %s failed.\n  Exited with status %d\n", iso_jobs[j].t->name, WEXITSTATUS(res->status));
+	break;
+    default:
+	report_failure(iso_jobs[j].t, &res->fail);
+	break;
+    }
+    return 1;
 }
 
 /* 
- * test_function - Test a function.  Return number of errors 
+ * stop_isolated - Kill the worker processes of the isolation pool,
+ *    some of which may still be running jobs that weren't needed
  */
-static int test_function(test_ptr t) {
-    int test_counts[3];    /* number of test values for each arg */
-    int args = t->args;    /* number of function arguments */
-    int arg_test_range[3]; /* test range for each argument */
-    int i, a1, a2, a3;        
-    int errors = 0;
+static void stop_isolated(void)
+{
+    int i;
 
-    /* These are the test values for each arg. Declared with the
-       static attribute so that the array will be allocated in bss
-       rather than the stack */
-    static int arg_test_vals[3][MAX_TEST_VALS]; 
+    for (i = 0; i < num_procs; i++)
+	if (procs[i].pid > 0) {
+	    kill(procs[i].pid, SIGKILL);
+	    reap_proc(&procs[i], ISO_SKIPPED);
+	}
+}
 
-    /* Sanity check on the number of args */
-    if (args < 0 || args > 3) {
-	printf("Configuration error: invalid number of args (%d) for function %s\n", args, t->name);
-	exit(1);
-    }
+/* 
+ * read_file - Return the contents of file name, or exit if it can't
+ *    be read
+ */
+static char *read_file(char *name)
+{
+    FILE *fp = fopen(name, "r");
+    char *buf;
+    long n;
 
-    /* Assign range of argument test vals so as to conserve the total
-       number of tests, independent of the number of arguments */
-    if (args == 1) {
-	arg_test_range[0] = TEST_RANGE;
-    }
-    else if (args == 2) {
-	arg_test_range[0] = pow((double)TEST_RANGE, 0.5);  /* sqrt */
-	arg_test_range[1] = arg_test_range[0];
+    if (fp == NULL || fseek(fp, 0, SEEK_END) < 0 || (n = ftell(fp)) < 0) {
+	printf("Can't read %s\n", name);
+	exit(1);
     }
-    else {
-	arg_test_range[0] = pow((double)TEST_RANGE, 0.333); /* cbrt */
-	arg_test_range[1] = arg_test_range[0];
-	arg_test_range[2] = arg_test_range[0];
+    rewind(fp);
+    buf = malloc(n + 1);
+    if (buf == NULL) {
+	printf("Out of memory\n");
+	exit(1);
     }
+    n = fread(buf, 1, n, fp);
+    buf[n] = '\0';
+    fclose(fp);
+    return buf;
+}
 
-    /* Sanity check on the ranges */
-    if (arg_test_range[0] < 1)
-	arg_test_range[0] = 1;
-    if (arg_test_range[1] < 1) 
-	arg_test_range[1] = 1;
-    if (arg_test_range[2] < 1) 
-	arg_test_range[2] = 1;
-
-    /* Create a test set for each argument */
-    for (i = 0; i < args; i++) {
-	test_counts[i] =  gen_vals(arg_test_vals[i], 
-				   t->arg_ranges[i][0], /* min */
-				   t->arg_ranges[i][1], /* max */
-				   arg_test_range[i],   
-				   i);
-
-    }
+/* 
+ * prove_function - Prove function t correct on every input with the
+ *    BDD checker, or find an input where it fails. Functions that
+ *    the checker can't handle are tested as usual. Return the number
+ *    of errors (0 or 1).
+ */
+static int prove_function(test_ptr t)
+{
+    static batch_t b;
+    char why[256];
+    int args[3], nodes, bits, k;
+    fail_t fail;
 
-    /* Handle timeouts in the test code */
+    /* Handle timeouts in the solution, and in the checker */
     if (timeout_limit > 0) {
 	int rc;
 	rc = sigsetjmp(envbuf, 1);
 	if (rc) {
 	    /* control will reach here if there is a timeout */
-	    errors = 1;
 	    printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
-	    return errors;
+	    return 1;
 	}
 	alarm(timeout_limit);
     }
 
-
-    /* Test function has no arguments */
-    if (args == 0) {
-	errors += test_0_arg(t->solution_funct, t->test_funct, t->name);
-	return errors;
-    } 
-
-    /* 
-     * Test function has at least one argument 
-     */
-      
-    /* Iterate over the values for first argument */
-
-    for (a1 = 0; a1 < test_counts[0]; a1++) {
-	if (args == 1) {
-	    errors += test_1_arg(t->solution_funct, 
-				 t->test_funct,
-				 arg_test_vals[0][a1],
-				 t->name);
-
-	    /* Stop testing if there is an error */
-	    if (errors)
-		return errors;
-	} 
+    switch (bdd_check(t, bits_src, args, &nodes, why, sizeof(why))) {
+    case BDD_EQUAL:
+	for (k = bits = 0; k < t->args; k++)
+	    bits += (int) ceil(log2((double) t->arg_ranges[k][1] - 
+				    t->arg_ranges[k][0] + 1));
+	if (!grade && bits == 0)
+	    printf("Proved %s correct (%d BDD nodes)\n", t->name, nodes);
+	else if (!grade)
+	    printf("Proved %s correct on all 2^%d inputs (%d BDD nodes)\n",
+		   t->name, bits, nodes);
+	return 0;
+    case BDD_DIFFERENT:
+	memset(&fail, 0, sizeof(fail));
+	if (t->args == 0)
+	    test_0_arg(t->solution_funct, t->test_funct, &fail);
 	else {
-	    /* if necessary, iterate over values for second argument */
-	    for (a2 = 0; a2 < test_counts[1]; a2++) {
-		if (args == 2) {
-		    errors += test_2_arg(t->solution_funct, 
-					 t->test_funct,
-					 arg_test_vals[0][a1], 
-					 arg_test_vals[1][a2],
-					 t->name);
-
-		    /* Stop testing if there is an error */
-		    if (errors)
-			return errors;
-		} 
-		else {
-		    /* if necessary, iterate over vals for third arg */
-		    for (a3 = 0; a3 < test_counts[2]; a3++) {
-			errors += test_3_arg(t->solution_funct, 
-					     t->test_funct,
-					     arg_test_vals[0][a1], 
-					     arg_test_vals[1][a2],
-					     arg_test_vals[2][a3],
-					     t->name);
-			
-			/* Stop testing if there is an error */
-			if (errors)
-			    return errors;
-		    } /* a3 */
-		}
-	    } /* a2 */
+	    for (k = 0; k < t->args; k++)
+		b.args[k][0] = args[k];
+	    b.index[0] = 0;
+	    b.n = 1;
+	    check_batch(t, &b, &fail);
 	}
-    } /* a1 */
-
-    
-    return errors;
+	report_failure(t, &fail);
+	return 1;
+    default:
+	if (!grade)
+	    printf("Can't prove %s: %s. Testing it instead.\n", t->name, why);
+	return test_function(t);
+    }
 }
 
 /* 
@@ -423,11 +2211,18 @@ static int test_function(test_ptr t) {
  */ 
 static int run_tests() 
 {
-    int i;
+    int i, j = 0;
     int errors = 0;
     double points = 0.0;
     double max_points = 0.0;
 
+    if (!prove && !fuzz_secs && !classes) {
+	if (num_procs > 0)
+	    start_isolated();
+	else if (num_threads > 1 || exhaustive)
+	    start_jobs();
+    }
+
     printf("Score\tRating\tErrors\tFunction\n");
 
     for (i = 0; test_set[i].solution_funct; i++) {
@@ -436,7 +2231,18 @@ static int run_tests()
 	double tpoints;
 	if (!test_fname || strcmp(test_set[i].name,test_fname) == 0) {
 	    int rating = global_rating ? global_rating : test_set[i].rating;
-	    terrors = test_function(&test_set[i]);
+	    if (prove)
+		terrors = prove_function(&test_set[i]);
+	    else if (fuzz_secs > 0)
+		terrors = fuzz_test(&test_set[i]);
+	    else if (classes)
+		terrors = class_test(&test_set[i]);
+	    else if (num_procs > 0)
+		terrors = wait_isolated(j++);
+	    else if (num_threads > 1 || exhaustive)
+		terrors = wait_job(j++);
+	    else
+		terrors = test_function(&test_set[i]);
 	    errors += terrors;
 	    tscore = terrors == 0 ? 1.0 : 0.0;
 	    tpoints = rating * tscore;
@@ -450,10 +2256,203 @@ static int run_tests()
 	}
     }
 
+    if (!prove && !fuzz_secs && !classes && num_procs > 0)
+	stop_isolated();
     printf("Total points: %.0f/%.0f\n", points, max_points);
     return errors;
 }
 
+/* 
+ * read_tsc - Return the time stamp counter, or 0 if there isn't one 
+ */
+static unsigned long long read_tsc(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned hi, lo;
+
+    asm volatile("rdtsc" : "=d" (hi), "=a" (lo));
+    return (unsigned long long) hi << 32 | lo;
+#else
+    return 0;
+#endif
+}
+
+/* 
+ * bench_calls - Call f, a function with args arguments, on each test
+ *    of batch b, and put the results in b->r
+ */
+static void bench_calls(funct_t f, int args, batch_t *b)
+{
+    int i;
+
+    switch (args) {
+    case 0:
+	for (i = 0; i < b->n; i++)
+	    b->r[i] = f();
+	break;
+    case 1:
+	for (i = 0; i < b->n; i++)
+	    b->r[i] = ((funct1_t) f)(b->args[0][i]);
+	break;
+    case 2:
+	for (i = 0; i < b->n; i++)
+	    b->r[i] = ((funct2_t) f)(b->args[0][i], b->args[1][i]);
+	break;
+    default:
+	for (i = 0; i < b->n; i++)
+	    b->r[i] = ((funct3_t) f)(b->args[0][i], b->args[1][i], 
+				     b->args[2][i]);
+	break;
+    }
+}
+
+/* 
+ * bench_time - Use the K-best scheme of fcyc (in malloclab) to time
+ *    f (or the batch version bt if f is NULL) on batch b. Each sample
+ *    runs the whole batch BENCH_REPS times. Sets *ns and *cycles to
+ *    the time per call of the fastest sample, and *cycles to -1 if
+ *    there is no cycle counter.
+ */
+static void bench_time(funct_t f, batch_rec *bt, int args, batch_t *b, 
+		       double *ns, double *cycles)
+{
+    double best_ns[BENCH_K], best_cyc[BENCH_K];
+    struct timespec start, end;
+    unsigned long long c0, c1;
+    double sns, scyc;
+    int samples = 0;
+    int i, pos;
+
+    do {
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	c0 = read_tsc();
+	for (i = 0; i < BENCH_REPS; i++) {
+	    if (f)
+		bench_calls(f, args, b);
+	    else if (bt->batch1)
+		bt->batch1(b->args[0], b->r, b->n);
+	    else
+		bt->batch2(b->args[0], b->args[1], b->r, b->n);
+	}
+	c1 = read_tsc();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sns = ((end.tv_sec - start.tv_sec) * 1e9 + 
+	       (end.tv_nsec - start.tv_nsec)) / ((double) BENCH_REPS * b->n);
+	scyc = (double) (c1 - c0) / ((double) BENCH_REPS * b->n);
+
+	/* Keep the K smallest samples in order, by time */
+	pos = samples < BENCH_K ? samples : BENCH_K - 1;
+	if (samples < BENCH_K || sns < best_ns[pos]) {
+	    best_ns[pos] = sns;
+	    best_cyc[pos] = scyc;
+	    for (; pos > 0 && best_ns[pos - 1] > best_ns[pos]; pos--) {
+		sns = best_ns[pos - 1];
+		best_ns[pos - 1] = best_ns[pos];
+		best_ns[pos] = sns;
+		scyc = best_cyc[pos - 1];
+		best_cyc[pos - 1] = best_cyc[pos];
+		best_cyc[pos] = scyc;
+	    }
+	}
+	samples++;
+    } while (samples < BENCH_MAXSAMPLES && 
+	     (samples < BENCH_K || 
+	      (1 + BENCH_EPSILON) * best_ns[0] < best_ns[BENCH_K - 1]));
+
+    *ns = best_ns[0];
+    *cycles = c1 > c0 ? best_cyc[0] : -1;
+}
+
+/* 
+ * print_time - Print a time per call from bench_time, or - if there
+ *    wasn't one
+ */
+static void print_time(double ns, double cycles)
+{
+    if (ns < 0)
+	printf("%8s %8s", "-", "-");
+    else if (cycles < 0)
+	printf("%8.2f %8s", ns, "-");
+    else
+	printf("%8.2f %8.2f", ns, cycles);
+}
+
+/* 
+ * bench_function - Time the solution of function t, its test
+ *    function, and the batch version of the test function, if there
+ *    is one, on the first BATCH_TESTS of its usual test values, and
+ *    print a line of the times per call. Return the number of errors
+ *    (0 or 1, if the solution timed out).
+ */
+static int bench_function(test_ptr t) {
+    static job_t job;
+    static batch_t b;
+    static int first[BATCH_TESTS];
+    batch_rec *bt = batch_refs[t - test_set];
+    double ns[3], cycles[3];
+    int i, k, n;
+
+    /* Handle timeouts in the solution */
+    if (timeout_limit > 0) {
+	int rc;
+	rc = sigsetjmp(envbuf, 1);
+	if (rc) {
+	    /* control will reach here if there is a timeout */
+	    printf("\nERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
+	    free_job(&job);
+	    return 1;
+	}
+	alarm(timeout_limit);
+    }
+
+    /* The test values, with the first argument's repeated if there
+       are fewer than a batch of them */
+    init_job(&job, t);
+    n = t->args > 0 ? gen_next(&job.first, first, BATCH_TESTS) : 1;
+    for (i = 0; i < BATCH_TESTS; i++) {
+	b.args[0][i] = first[i % n];
+	for (k = 1; k < t->args; k++)
+	    b.args[k][i] = job.vals[k][i % job.counts[k]];
+    }
+    b.n = BATCH_TESTS;
+
+    printf("%-16s", t->name);
+    fflush(stdout);
+    bench_time(t->solution_funct, NULL, t->args, &b, &ns[0], &cycles[0]);
+    bench_time(t->test_funct, NULL, t->args, &b, &ns[1], &cycles[1]);
+    ns[2] = cycles[2] = -1;
+    if (bt)
+	bench_time(NULL, bt, t->args, &b, &ns[2], &cycles[2]);
+    alarm(0);
+
+    for (i = 0; i < 3; i++) {
+	printf("  ");
+	print_time(ns[i], cycles[i]);
+    }
+    printf("\n");
+    free_job(&job);
+    return 0;
+}
+
+/* 
+ * run_bench - Time each function (-b). Return number of errors 
+ */
+static int run_bench(void)
+{
+    int i, errors = 0;
+
+    printf("%-16s  %17s  %17s  %17s\n", "", "solution", "reference", 
+	   "builtin");
+    printf("%-16s", "Function");
+    for (i = 0; i < 3; i++)
+	printf("  %8s %8s", "ns/call", "cyc/call");
+    printf("\n");
+    for (i = 0; test_set[i].solution_funct; i++)
+	if (!test_fname || strcmp(test_set[i].name, test_fname) == 0)
+	    errors += bench_function(&test_set[i]);
+    return errors;
+}
+
 /* 
  * get_num_val - Extract hex/decimal/or float value from string 
  */
@@ -506,14 +2505,26 @@ static int get_num_val(char *sval, unsigned *valp) {
  * usage - Display usage info
  */
 static void usage(char *cmd) {
-    printf("Usage: %s [-hg] [-r <n>] [-f <name> [-1|-2|-3 <val>]*] [-T <time limit>]\n", cmd);
+    printf("Usage: %s [-hgbP] [-r <n>] [-f <name> [-1|-2|-3 <val>]*] [-T <time limit>]\n", cmd);
+    printf("       [-j <n>] [-e] [-c] [-F <secs> [-D <dir>] [-s <seed>]]\n");
+    printf("       [-p <n> [-t <ms>]]\n");
     printf("  -1 <val>  Specify first function argument\n");
     printf("  -2 <val>  Specify second function argument\n");
     printf("  -3 <val>  Specify third function argument\n");
+    printf("  -b        Time each function instead of testing it\n");
+    printf("  -c        Test on classes of bit patterns, and show coverage\n");
+    printf("  -D <dir>  Keep the fuzzing corpus in directory dir\n");
+    printf("  -e        Check one-argument functions on every input\n");
     printf("  -f <name> Test only the named function\n");
+    printf("  -F <secs> Fuzz each function for secs seconds\n");
     printf("  -g        Compact output for grading (with no error msgs)\n");
     printf("  -h        Print this message\n");
+    printf("  -j <n>    Run the tests in n threads\n");
+    printf("  -p <n>    Run the tests in n worker processes\n");
+    printf("  -P        Prove functions correct on every input with BDDs\n");
     printf("  -r <n>    Give uniform weight of n for all problems\n");
+    printf("  -s <seed> Seed the mutations of -F with seed\n");
+    printf("  -t <ms>   Set timeout limit of -p to ms milliseconds\n");
     printf("  -T <lim>  Set timeout limit to lim\n");
     exit(1);
 }
@@ -529,7 +2540,7 @@ int main(int argc, char *argv[])
     char c;
 
     /* parse command line args */
-    while ((c = getopt(argc, argv, "hgf:r:T:1:2:3:")) != -1)
+    while ((c = getopt(argc, argv, "hgbcePf:r:T:t:j:p:F:D:s:1:2:3:")) != -1)
         switch (c) {
         case 'h': /* help */
 	    usage(argv[0]);
@@ -569,16 +2580,69 @@ int main(int argc, char *argv[])
 	case 'T': /* Set timeout limit */
 	    timeout_limit = atoi(optarg);
 	    break;
+	case 'P': /* Prove the functions correct */
+	    prove = 1;
+	    break;
+	case 'b': /* Time the functions */
+	    bench = 1;
+	    break;
+	case 'F': /* Fuzz each function */
+	    fuzz_secs = atoi(optarg);
+	    if (fuzz_secs < 1)
+		usage(argv[0]);
+	    break;
+	case 'D': /* Keep the fuzzing corpus here */
+	    corpus_dir = strdup(optarg);
+	    break;
+	case 's': /* Seed the fuzzer */
+	    fuzz_seed = strtoul(optarg, NULL, 0);
+	    has_fuzz_seed = 1;
+	    break;
+	case 'c': /* Test the arguments on classes of bit patterns */
+	    classes = 1;
+	    break;
+	case 'p': /* Run the tests in worker processes */
+	    num_procs = atoi(optarg);
+	    if (num_procs < 1)
+		usage(argv[0]);
+	    break;
+	case 't': /* Set timeout limit of -p in milliseconds */
+	    iso_timeout_ms = atol(optarg);
+	    break;
+	case 'e': /* Check every input of one-argument functions */
+	    exhaustive = 1;
+	    break;
+	case 'j': /* Run the tests in worker threads */
+	    num_threads = atoi(optarg);
+	    if (num_threads < 1)
+		usage(argv[0]);
+	    break;
 	default:
 	    usage(argv[0]);
 	}
 
+    if (num_threads == 0)
+	num_threads = exhaustive ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    if (num_threads < 1)
+	num_threads = 1;
+    if (iso_timeout_ms < 0)
+	iso_timeout_ms = timeout_limit * 1000L;
+    if (!has_fuzz_seed)
+	fuzz_seed = (unsigned) time(NULL);
+
     if (timeout_limit > 0) {
 	Signal(SIGALRM, timeout_handler);
     }
 
-    /* test each function */
-    errors = run_tests();
+    init_batch_refs();
+    if (prove)
+	bits_src = read_file("bits.c");
+
+    /* test (or time) each function */
+    if (bench)
+	errors = run_bench();
+    else
+	errors = run_tests();
 
     return 0;
 }
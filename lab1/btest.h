@@ -24,9 +24,15 @@ typedef struct {
 
 extern test_rec test_set[];
 
+/* Batch versions of some of the test functions, which compute the
+   results for n arguments at once. Defined in tests.c. */
+typedef void (*batch1_t)(const int *x, int *r, int n);
+typedef void (*batch2_t)(const int *x, const int *y, int *r, int n);
 
+typedef struct {
+    char *name;        /* Name of the function in test_set */
+    batch1_t batch1;   /* Batch test function with one argument, */
+    batch2_t batch2;   /* or with two (the other is NULL) */
+} batch_rec;
 
-
-
-
-
+extern batch_rec batch_set[];
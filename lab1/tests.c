@@ -2,6 +2,11 @@
 
 #include <limits.h>
 #include <math.h>
+#include <stddef.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "btest.h"
 
 /* Routines used by floation point test code */
 
@@ -133,3 +138,164 @@ unsigned test_float_twice(unsigned uf) {
   else
     return f2u(tf);
 }
+/* Batch versions of the test functions
+ *
+ * Each computes the test function for n arguments at once, so that
+ * btest doesn't have to make a call per test. btest checks them against
+ * the test functions above when it starts, and uses the test function
+ * instead of one that disagrees.
+ */
+
+#ifdef __SSE2__
+/* Apply the SSE2 expression EXPR(v) to x[0..n-1], four at a time, and
+   store the results in r. Leftover elements are done with SCALAR(x). */
+#define BATCH1_SSE2(x, r, n, EXPR, SCALAR) do {				\
+    int i_;								\
+    __m128i v;								\
+    for (i_ = 0; i_ + 4 <= (n); i_ += 4) {				\
+	v = _mm_loadu_si128((__m128i *) ((x) + i_));			\
+	_mm_storeu_si128((__m128i *) ((r) + i_), EXPR(v));		\
+    }									\
+    for (; i_ < (n); i_++)						\
+	(r)[i_] = SCALAR((x)[i_]);					\
+} while (0)
+#endif
+
+static int parity_1(int x)
+{
+  return __builtin_parity((unsigned) x);
+}
+static int any_odd_1(int x)
+{
+  return (x & 0xAAAAAAAA) != 0;
+}
+static int float_abs_1(int x)
+{
+  int a = x & 0x7fffffff;
+  return a > 0x7f800000 ? x : a;   /* NaN is left alone */
+}
+
+void test_bitParity_batch(const int *x, int *r, int n)
+{
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = parity_1(x[i]);
+}
+void test_anyOddBit_batch(const int *x, int *r, int n)
+{
+#ifdef __SSE2__
+#define ANY_ODD(v) \
+  _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(v, \
+    _mm_set1_epi32(0xAAAAAAAA)), _mm_setzero_si128()), _mm_set1_epi32(1))
+  BATCH1_SSE2(x, r, n, ANY_ODD, any_odd_1);
+#else
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = any_odd_1(x[i]);
+#endif
+}
+void test_isTmin_batch(const int *x, int *r, int n)
+{
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = x[i] == INT_MIN;
+}
+void test_negate_batch(const int *x, int *r, int n)
+{
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = (int) (0u - (unsigned) x[i]);
+}
+void test_isNonZero_batch(const int *x, int *r, int n)
+{
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = x[i] != 0;
+}
+void test_float_abs_batch(const int *x, int *r, int n)
+{
+#ifdef __SSE2__
+  /* Clear the sign, except of NaNs (whose magnitude is above inf) */
+#define FLOAT_ABS(v) \
+  _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi32(_mm_and_si128(v, \
+    _mm_set1_epi32(0x7fffffff)), _mm_set1_epi32(0x7f800000)), v), \
+    _mm_and_si128(v, _mm_set1_epi32(0x7fffffff)))
+  BATCH1_SSE2(x, r, n, FLOAT_ABS, float_abs_1);
+#else
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = float_abs_1(x[i]);
+#endif
+}
+void test_float_f2i_batch(const int *x, int *r, int n)
+{
+#ifdef __SSE2__
+  /* cvttps2dq truncates, and gives 0x80000000 when out of range, like
+     the (int) cast of test_float_f2i */
+#define FLOAT_F2I(v) _mm_cvttps_epi32(_mm_castsi128_ps(v))
+  BATCH1_SSE2(x, r, n, FLOAT_F2I, test_float_f2i);
+#else
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = test_float_f2i(x[i]);
+#endif
+}
+void test_float_twice_batch(const int *x, int *r, int n)
+{
+  int i = 0;
+#ifdef __SSE2__
+  __m128i v, nan, twice;
+
+  /* 2*f, except that a NaN is returned as is */
+  for (; i + 4 <= n; i += 4) {
+    v = _mm_loadu_si128((__m128i *) (x + i));
+    nan = _mm_cmpgt_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7fffffff)),
+			  _mm_set1_epi32(0x7f800000));
+    twice = _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(v),
+					_mm_castsi128_ps(v)));
+    _mm_storeu_si128((__m128i *) (r + i), 
+		     _mm_or_si128(_mm_and_si128(nan, v), 
+				  _mm_andnot_si128(nan, twice)));
+  }
+#endif
+  for (; i < n; i++)
+    r[i] = test_float_twice(x[i]);
+}
+
+void test_bitOr_batch(const int *x, const int *y, int *r, int n)
+{
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = x[i] | y[i];
+}
+void test_addOK_batch(const int *x, const int *y, int *r, int n)
+{
+  int i;
+  unsigned s;
+  for (i = 0; i < n; i++) {
+    /* Overflow iff the sum's sign differs from both operands' */
+    s = (unsigned) x[i] + (unsigned) y[i];
+    r[i] = (int) (((x[i] ^ s) & (y[i] ^ s)) >> 31) == 0;
+  }
+}
+void test_isGreater_batch(const int *x, const int *y, int *r, int n)
+{
+  int i;
+  for (i = 0; i < n; i++)
+    r[i] = x[i] > y[i];
+}
+
+batch_rec batch_set[] = {
+  {"bitParity", test_bitParity_batch, NULL},
+  {"anyOddBit", test_anyOddBit_batch, NULL},
+  {"isTmin", test_isTmin_batch, NULL},
+  {"negate", test_negate_batch, NULL},
+  {"isNonZero", test_isNonZero_batch, NULL},
+  {"float_abs", test_float_abs_batch, NULL},
+  {"float_f2i", test_float_f2i_batch, NULL},
+  {"float_twice", test_float_twice_batch, NULL},
+  {"bitOr", NULL, test_bitOr_batch},
+  {"addOK", NULL, test_addOK_batch},
+  {"isGreater", NULL, test_isGreater_batch},
+  {NULL, NULL, NULL}
+};
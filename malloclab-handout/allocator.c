@@ -0,0 +1,58 @@
+/*
+ * allocator.c - The table of malloc packages that mdriver can evaluate
+ *
+ * "mm" is the package in mm.c and "libc" is the C library's malloc.
+ * Building with MM_ALT set to another version of mm.c, e.g.
+ *
+ *     unix> git show HEAD~1:./mm.c > mm-old.c
+ *     unix> make MM_ALT=mm-old.c
+ *
+ * adds it as "alt"; the Makefile renames its mm_* functions to alt_mm_*
+ * and hides all of its other globals so that it can be linked next to
+ * mm.c. To add some other engine, give it an init/malloc/free/realloc
+ * quartet with names of its own and add an entry below.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "mm.h"
+
+#ifdef MM_ALT
+extern int alt_mm_init(void);
+extern void *alt_mm_malloc(size_t size);
+extern void alt_mm_free(void *ptr);
+extern void *alt_mm_realloc(void *ptr, size_t size);
+/* Older versions of mm.c may not have the -T introspection hook */
+extern void alt_mm_freeinfo(size_t *free_blocks, size_t *largest_free)
+    __attribute__((weak));
+#endif
+
+/* libc malloc has no heap of its own for us to reset */
+static int libc_init(void)
+{
+    return 0;
+}
+
+allocator_t allocators[] = {
+    {"mm", "mm.c", 1,
+     mm_init, mm_malloc, mm_free, mm_realloc, mm_freeinfo},
+#ifdef MM_ALT
+    {"alt", MM_ALT, 1,
+     alt_mm_init, alt_mm_malloc, alt_mm_free, alt_mm_realloc,
+     alt_mm_freeinfo},
+#endif
+    {"libc", "libc malloc", 0,
+     libc_init, malloc, free, realloc, NULL},
+    {NULL}
+};
+
+allocator_t *find_allocator(char *name)
+{
+    allocator_t *a;
+
+    for (a = allocators; a->name != NULL; a++)
+	if (!strcmp(a->name, name))
+	    return a;
+    return NULL;
+}
@@ -0,0 +1,30 @@
+/*
+ * allocator.h - The malloc packages that mdriver can evaluate
+ *
+ * Each package is described by a table of entry points, so that one
+ * driver binary can replay the same traces against several of them
+ * (see the -A flag of mdriver).
+ */
+#ifndef __ALLOCATOR_H_
+#define __ALLOCATOR_H_
+
+#include <stddef.h>
+
+typedef struct {
+    char *name;          /* name used to select it with mdriver -A */
+    char *desc;          /* one line description */
+    int uses_memlib;     /* heap comes from mem_sbrk, so util is defined */
+    int (*init)(void);   /* start with an empty heap; -1 on error */
+    void *(*malloc)(size_t size);
+    void (*free)(void *ptr);
+    void *(*realloc)(void *ptr, size_t size);
+    void (*freeinfo)(size_t *free_blocks, size_t *largest_free); /* or NULL */
+} allocator_t;
+
+/* The available packages, terminated by an entry with a NULL name */
+extern allocator_t allocators[];
+
+/* Return the package called name, or NULL if there isn't one */
+allocator_t *find_allocator(char *name);
+
+#endif /* __ALLOCATOR_H_ */
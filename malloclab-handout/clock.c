@@ -10,6 +10,10 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/times.h>
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
 #include "clock.h"
 
 
@@ -71,6 +75,38 @@ double get_counter()
 }
 /* $end x86cyclecounter */
 
+#elif defined(__x86_64__)
+/*******************************************************
+ * x86-64 versions of start_counter() and get_counter()
+ *******************************************************/
+
+static unsigned cyc_hi = 0;
+static unsigned cyc_lo = 0;
+
+/* Set *hi and *lo to the high and low order bits of the cycle counter */
+void access_counter(unsigned *hi, unsigned *lo)
+{
+    asm volatile("rdtsc" : "=d" (*hi), "=a" (*lo));
+}
+
+/* Record the current value of the cycle counter. */
+void start_counter()
+{
+    access_counter(&cyc_hi, &cyc_lo);
+}
+
+/* Return the number of cycles since the last call to start_counter. */
+double get_counter()
+{
+    unsigned ncyc_hi, ncyc_lo;
+    unsigned long long start, now;
+
+    access_counter(&ncyc_hi, &ncyc_lo);
+    start = ((unsigned long long)cyc_hi << 32) | cyc_lo;
+    now = ((unsigned long long)ncyc_hi << 32) | ncyc_lo;
+    return (double)(now - start);
+}
+
 #elif defined(__alpha)
 
 /****************************************************
@@ -201,6 +237,94 @@ double mhz(int verbose)
     return mhz_full(verbose, 2);
 }
 
+/*
+ * Invariant time stamp counter support. On processors with an
+ * invariant TSC the cycle counter ticks at a constant rate regardless
+ * of frequency scaling and sleep states, so it can be used as a
+ * high-resolution clock once that rate is known.
+ */
+
+/* Return 1 if the processor advertises an invariant TSC */
+int tsc_invariant()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned eax, ebx, ecx, edx;
+
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+	return (edx >> 8) & 1;
+#endif
+    return 0;
+}
+
+/* Return the current CLOCK_MONOTONIC_RAW time in seconds */
+static double raw_secs()
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 
+ * tsc_mhz - Return the TSC rate in MHz, or 0 if there is no TSC. The
+ *     rate is read from CPUID leaf 0x15 when the processor reports
+ *     it, and otherwise calibrated against CLOCK_MONOTONIC_RAW over
+ *     TSC_CALIB_MS milliseconds (median of TSC_CALIB_TRIES tries), 
+ *     instead of the two-second sleep used by mhz().
+ */
+#define TSC_CALIB_MS 20
+#define TSC_CALIB_TRIES 5
+
+double tsc_mhz(int verbose)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned eax, ebx, ecx, edx;
+    double rate, r[TSC_CALIB_TRIES], t0, t1, cyc;
+    int i, j;
+
+    if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) && eax >= 0x15) {
+	__cpuid(0x15, eax, ebx, ecx, edx);
+	if (eax != 0 && ebx != 0 && ecx != 0) {
+	    rate = (double)ecx * ebx / eax / 1e6;
+	    if (verbose)
+		printf("TSC rate from CPUID = %.1f MHz\n", rate);
+	    return rate;
+	}
+    }
+
+    /* 
+     * The counter is read right next to each clock read. Preemption 
+     * between the two still adds cycles or seconds that the other 
+     * doesn't see, and can push a try either way, so take the median.
+     */
+    for (i = 0; i < TSC_CALIB_TRIES; i++) {
+	start_counter();
+	t0 = raw_secs();
+	do {
+	    t1 = raw_secs();
+	} while (t1 - t0 < TSC_CALIB_MS * 1e-3);
+	cyc = get_counter();
+	r[i] = cyc / ((t1 - t0) * 1e6);
+	for (j = i; j > 0 && r[j - 1] > r[j]; j--) {
+	    double tmp = r[j];
+	    r[j] = r[j - 1];
+	    r[j - 1] = tmp;
+	}
+    }
+    rate = r[TSC_CALIB_TRIES / 2];
+    if (verbose)
+	printf("TSC rate (calibrated) ~= %.1f MHz%s\n", rate, 
+	       tsc_invariant() ? "" : " (WARNING: TSC is not invariant)");
+    return rate;
+#else
+    return 0;
+#endif
+}
+
 /** Special counters that compensate for timer interrupt overhead */
 
 static double cyc_per_tick = 0.0;
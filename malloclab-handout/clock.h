@@ -15,6 +15,12 @@ double mhz(int verbose);
 /* Determine clock rate of processor, having more control over accuracy */
 double mhz_full(int verbose, int sleeptime);
 
+/* Does the processor have an invariant (constant rate) TSC? */
+int tsc_invariant();
+
+/* Rate of the TSC in MHz, from CPUID or a short calibration (0 if none) */
+double tsc_mhz(int verbose);
+
 /** Special counters that compensate for timer interrupt overhead */
 
 void start_comp_counter();
@@ -42,13 +42,17 @@
  * students surpass the AVG_LIBC_THRUPUT, they get no further benefit
  * to their score.  This deters students from building extremely fast,
  * but extremely stupid malloc packages.
+ *
+ * mdriver's -R flag overrides this constant, and -M replaces it with
+ * the throughput of libc malloc measured on the same traces.
  */
 #define AVG_LIBC_THRUPUT      12176E3  /* 600 Kops/sec */
 
  /* 
   * This constant determines the contributions of space utilization
   * (UTIL_WEIGHT) and throughput (1 - UTIL_WEIGHT) to the performance
-  * index.  
+  * index. mdriver's -w flag replaces both weights, and can also weigh
+  * in request latency and the heap's resident memory.
   */
 #define UTIL_WEIGHT .60
 
@@ -58,12 +62,17 @@
 #define ALIGNMENT 8  
 
 /* 
- * Maximum heap size in bytes 
+ * Maximum heap size in bytes. May be overridden on the compiler
+ * command line (the libmm.so target reserves a much larger region).
  */
+#ifndef MAX_HEAP
 #define MAX_HEAP (20*(1<<20))  /* 20 MB */
+#endif
 
 /*****************************************************************************
- * Set exactly one of these USE_xxx constants to "1" to select a timing method
+ * Set exactly one of these USE_xxx constants to "1" to select the default
+ * timing method. mdriver's -c flag selects any method at runtime, including
+ * the "monotonic" (clock_gettime) and "tsc" (invariant TSC) timers.
  *****************************************************************************/
 #define USE_FCYC   0   /* cycle counter w/K-best scheme (x86 & Alpha only) */
 #define USE_ITIMER 0   /* interval timer (any Unix box) */
@@ -0,0 +1,108 @@
+/*
+ * fcache.c - Flush the CPU caches before a timed replay
+ *
+ * fcyc.c can clear a fixed 512 KB of cache before each sample, which
+ * is smaller than the last level cache of any current machine. Here
+ * the flush buffer is sized from the cache geometry the kernel
+ * reports in sysfs: it is FLUSH_FACTOR times the largest data cache,
+ * since caches are not perfectly LRU and a single pass over an
+ * LLC-sized buffer leaves some old lines behind.
+ *
+ * The buffer is written once when it is created and only read by
+ * fcache_flush. Reading is enough to evict the lines of whatever ran
+ * before (dirty lines are written back on the way out), and it lets
+ * the worker processes of mdriver -j share a single copy of the
+ * buffer instead of each touching hundreds of megabytes of its own.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "fcache.h"
+
+#define FLUSH_FACTOR 2   /* buffer size relative to the LLC */
+#define LINE_BYTES  64   /* stride of the flush loop */
+
+#define CACHE_DIR "/sys/devices/system/cpu/cpu0/cache"
+
+static char *flush_buf = NULL;
+static size_t flush_bytes = 0;
+static volatile char flush_sink; /* keeps the flush loop from being elided */
+
+/* Read the first line of a sysfs file into buf; 0 if there is none */
+static int read_sysfs(char *path, char *buf, int len)
+{
+    FILE *f;
+    int ok;
+
+    if ((f = fopen(path, "r")) == NULL)
+	return 0;
+    ok = (fgets(buf, len, f) != NULL);
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    return ok;
+}
+
+size_t fcache_llc_size(void)
+{
+    char path[256], buf[64];
+    int i, level, best_level = 0;
+    size_t size, best = 0;
+    char *end;
+
+    for (i = 0; ; i++) {
+	sprintf(path, "%s/index%d/level", CACHE_DIR, i);
+	if (!read_sysfs(path, buf, sizeof(buf)))
+	    break;
+	level = atoi(buf);
+	sprintf(path, "%s/index%d/type", CACHE_DIR, i);
+	if (!read_sysfs(path, buf, sizeof(buf)) || !strcmp(buf, "Instruction"))
+	    continue;
+	sprintf(path, "%s/index%d/size", CACHE_DIR, i);
+	if (!read_sysfs(path, buf, sizeof(buf)))
+	    continue;
+	size = strtoul(buf, &end, 10);
+	if (*end == 'K')
+	    size <<= 10;
+	else if (*end == 'M')
+	    size <<= 20;
+	if (level > best_level || (level == best_level && size > best)) {
+	    best_level = level;
+	    best = size;
+	}
+    }
+    return best ? best : FCACHE_DEFAULT_LLC;
+}
+
+size_t fcache_init(void)
+{
+    size_t i;
+
+    if (flush_buf != NULL)
+	return flush_bytes;
+    flush_bytes = FLUSH_FACTOR * fcache_llc_size();
+    flush_buf = mmap(NULL, flush_bytes, PROT_READ | PROT_WRITE, 
+		     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (flush_buf == MAP_FAILED) {
+	fprintf(stderr, "fcache_init: mmap of %lu bytes failed\n", 
+		(unsigned long)flush_bytes);
+	exit(1);
+    }
+    /* Give every page its own frame; untouched pages all map to zero */
+    for (i = 0; i < flush_bytes; i += LINE_BYTES)
+	flush_buf[i] = (char)i;
+    return flush_bytes;
+}
+
+void fcache_flush(void)
+{
+    char x = 0;
+    size_t i;
+
+    if (flush_buf == NULL)
+	fcache_init();
+    for (i = 0; i < flush_bytes; i += LINE_BYTES)
+	x ^= flush_buf[i];
+    flush_sink = x;
+}
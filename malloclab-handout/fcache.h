@@ -0,0 +1,32 @@
+/*
+ * fcache.h - prototypes for the routines in fcache.c that flush the
+ *     CPU caches so that a function can be timed cache-cold
+ */
+#ifndef __FCACHE_H_
+#define __FCACHE_H_
+
+#include <stddef.h>
+
+/* Assumed size of the last level cache if sysfs doesn't say */
+#define FCACHE_DEFAULT_LLC (8 << 20)
+
+/*
+ * fcache_llc_size - Size in bytes of the largest data cache of CPU 0,
+ *     read from /sys/devices/system/cpu/cpu0/cache
+ */
+size_t fcache_llc_size(void);
+
+/*
+ * fcache_init - Allocate and fill the buffer that fcache_flush reads.
+ *     Processes forked afterwards share it, so call it before forking.
+ *     Returns the size of the buffer.
+ */
+size_t fcache_init(void);
+
+/*
+ * fcache_flush - Evict everything else from the caches by reading a
+ *     buffer larger than the last level cache
+ */
+void fcache_flush(void);
+
+#endif /* __FCACHE_H_ */
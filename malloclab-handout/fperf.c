@@ -0,0 +1,136 @@
+/*
+ * fperf.c - Count hardware events while a function runs
+ *
+ * The timers in clock.c and ftimer.c say how long an allocator takes,
+ * but not why. These routines use the Linux perf_event_open interface
+ * to count retired instructions, cache and TLB misses, and branch
+ * mispredictions over the same kind of function call that fsecs
+ * times, so that a change that improves locality can be told apart
+ * from one that merely executes fewer instructions.
+ *
+ * Only user-level events of the calling process are counted, which is
+ * allowed at the default perf_event_paranoid level of 2. Each event
+ * has its own file descriptor rather than being in one group, so an
+ * event the hardware lacks does not prevent counting the others. If
+ * the kernel has to multiplex the counters, the counts are scaled by
+ * the fraction of the time each one was actually running.
+ */
+#include <string.h>
+#include <unistd.h>
+
+#include "fperf.h"
+
+char *fperf_event_names[FPERF_NUM_EVENTS] = {
+    "ins", "L1d", "LLC", "br", "dTLB"
+};
+
+#ifdef __linux__
+
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static struct {
+    unsigned type;
+    unsigned long long config;
+} events[FPERF_NUM_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+};
+
+static int fds[FPERF_NUM_EVENTS];
+static pid_t owner = 0;   /* process the counters were opened for */
+static int num_open = 0;
+
+/*
+ * Counters follow the process that opened them, so a child of fork
+ * (e.g. an mdriver -j worker) has to open its own
+ */
+int init_fperf(void)
+{
+    struct perf_event_attr attr;
+    int i;
+
+    if (owner == getpid())
+	return num_open;
+    if (owner != 0)
+	for (i = 0; i < FPERF_NUM_EVENTS; i++)
+	    if (fds[i] >= 0)
+		close(fds[i]);
+
+    owner = getpid();
+    num_open = 0;
+    for (i = 0; i < FPERF_NUM_EVENTS; i++) {
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = events[i].type;
+	attr.config = events[i].config;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+	    PERF_FORMAT_TOTAL_TIME_RUNNING;
+	fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if (fds[i] >= 0)
+	    num_open++;
+    }
+    return num_open;
+}
+
+int fperf(fsecs_test_funct f, void *argp, int n, double *counts)
+{
+    unsigned long long val[3]; /* value, time enabled, time running */
+    int i;
+
+    if (init_fperf() == 0) {
+	for (i = 0; i < FPERF_NUM_EVENTS; i++)
+	    counts[i] = -1;
+	return 0;
+    }
+
+    for (i = 0; i < FPERF_NUM_EVENTS; i++)
+	if (fds[i] >= 0) {
+	    ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+	    ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+	}
+    for (i = 0; i < n; i++)
+	f(argp);
+    for (i = 0; i < FPERF_NUM_EVENTS; i++)
+	if (fds[i] >= 0)
+	    ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+    for (i = 0; i < FPERF_NUM_EVENTS; i++) {
+	counts[i] = -1;
+	if (fds[i] < 0 || read(fds[i], val, sizeof(val)) != sizeof(val))
+	    continue;
+	if (val[2] == 0)   /* never got scheduled on a counter */
+	    continue;
+	counts[i] = (double)val[0] * ((double)val[1] / val[2]) / n;
+    }
+    return num_open;
+}
+
+#else /* !__linux__ */
+
+int init_fperf(void)
+{
+    return 0;
+}
+
+int fperf(fsecs_test_funct f, void *argp, int n, double *counts)
+{
+    int i;
+
+    for (i = 0; i < FPERF_NUM_EVENTS; i++)
+	counts[i] = -1;
+    return 0;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,39 @@
+/*
+ * fperf.h - prototypes for the routines in fperf.c that count
+ *     hardware events (via Linux perf_event_open) while a function runs
+ */
+#ifndef __FPERF_H_
+#define __FPERF_H_
+
+#include "fsecs.h"
+
+/* The events that are counted, in the order fperf reports them */
+#define FPERF_NUM_EVENTS 5
+enum {
+    FPERF_INSTRUCTIONS,   /* retired instructions */
+    FPERF_L1D_MISSES,     /* L1 data cache read misses */
+    FPERF_LLC_MISSES,     /* last level cache read misses */
+    FPERF_BRANCH_MISSES,  /* mispredicted branches */
+    FPERF_DTLB_MISSES     /* data TLB read misses */
+};
+
+/* Short names of the events, for column headings */
+extern char *fperf_event_names[FPERF_NUM_EVENTS];
+
+/*
+ * init_fperf - Open the counters for the calling process. Returns the
+ *     number of events that can be counted, which is 0 if the kernel
+ *     or the hardware doesn't support them (or perf_event_paranoid
+ *     forbids it).
+ */
+int init_fperf(void);
+
+/*
+ * fperf - Run f(argp) n times with the counters enabled and store the
+ *     average count of each event per run in counts. Events that
+ *     can't be counted are set to -1. Returns the number of events
+ *     counted.
+ */
+int fperf(fsecs_test_funct f, void *argp, int n, double *counts);
+
+#endif /* __FPERF_H_ */
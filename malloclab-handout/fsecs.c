@@ -2,16 +2,84 @@
  * High-level timing wrappers
  ****************************/
 #include <stdio.h>
+#include <string.h>
 #include "fsecs.h"
 #include "fcyc.h"
 #include "clock.h"
 #include "ftimer.h"
 #include "config.h"
 
+/* The available timing methods */
+enum { TIMER_FCYC, TIMER_ITIMER, TIMER_GETTOD, TIMER_MONOTONIC, TIMER_TSC };
+
+static struct {
+    char *name;
+    char *desc;
+} timers[] = {
+    {"fcyc",      "a cycle counter"},
+    {"itimer",    "the interval timer"},
+    {"gettod",    "gettimeofday()"},
+    {"monotonic", "clock_gettime(CLOCK_MONOTONIC_RAW)"},
+    {"tsc",       "the invariant TSC"},
+};
+#define NUM_TIMERS (sizeof(timers) / sizeof(timers[0]))
+
+/* The timer selected by set_fsecs_timer, defaulting to config.h's */
+#if USE_FCYC
+static int timer = TIMER_FCYC;
+#elif USE_ITIMER
+static int timer = TIMER_ITIMER;
+#else
+static int timer = TIMER_GETTOD;
+#endif
+
 static double Mhz;  /* estimated CPU clock frequency */
 
 extern int verbose; /* -v option in mdriver.c */
 
+/*
+ * set_fsecs_timer - Select the timing method by name. Returns 0 if
+ *     there is no such method. Must be called before init_fsecs.
+ */
+int set_fsecs_timer(char *name)
+{
+    unsigned i;
+
+    for (i = 0; i < NUM_TIMERS; i++) {
+	if (!strcmp(name, timers[i].name)) {
+	    timer = i;
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+/*
+ * fsecs_timer_names - Return a list of the timer names for usage messages
+ */
+char *fsecs_timer_names(void)
+{
+    static char names[128];
+    unsigned i;
+
+    names[0] = '\0';
+    for (i = 0; i < NUM_TIMERS; i++) {
+	strcat(names, timers[i].name);
+	if (i < NUM_TIMERS - 1)
+	    strcat(names, "|");
+    }
+    return names;
+}
+
+/*
+ * fsecs_timer_name - Return the name of the timer in use, which after
+ *     init_fsecs reflects any fallback to another method
+ */
+char *fsecs_timer_name(void)
+{
+    return timers[timer].name;
+}
+
 /*
  * init_fsecs - initialize the timing package
  */
@@ -19,39 +87,108 @@ void init_fsecs(void)
 {
     Mhz = 0; /* keep gcc -Wall happy */
 
-#if USE_FCYC
-    if (verbose)
-	printf("Measuring performance with a cycle counter.\n");
-
-    /* set key parameters for the fcyc package */
-    set_fcyc_maxsamples(20); 
-    set_fcyc_clear_cache(1);
-    set_fcyc_compensate(1);
-    set_fcyc_epsilon(0.01);
-    set_fcyc_k(3);
-    Mhz = mhz(verbose > 0);
-#elif USE_ITIMER
-    if (verbose)
-	printf("Measuring performance with the interval timer.\n");
-#elif USE_GETTOD
     if (verbose)
-	printf("Measuring performance with gettimeofday().\n");
-#endif
+	printf("Measuring performance with %s.\n", timers[timer].desc);
+
+    switch (timer) {
+    case TIMER_FCYC:
+    case TIMER_TSC:
+	/* set key parameters for the fcyc package */
+	set_fcyc_maxsamples(20); 
+	set_fcyc_clear_cache(1);
+	set_fcyc_compensate(1);
+	set_fcyc_epsilon(0.01);
+	set_fcyc_k(3);
+	if (timer == TIMER_FCYC) {
+	    Mhz = mhz(verbose > 0);
+	}
+	else if ((Mhz = tsc_mhz(verbose > 0)) <= 0) {
+	    printf("No TSC on this platform; using the monotonic clock.\n");
+	    timer = TIMER_MONOTONIC;
+	}
+	break;
+    default:
+	break;
+    }
 }
 
 /*
- * fsecs - Return the running time of a function f (in seconds)
+ * fsecs_reps - Return the average running time of n calls of f (in
+ *     seconds), timed together, with no K-best filtering, so that a
+ *     caller can do its own statistics over many samples
  */
-double fsecs(fsecs_test_funct f, void *argp) 
+double fsecs_reps(fsecs_test_funct f, void *argp, int n)
+{
+    int i;
+
+    switch (timer) {
+    case TIMER_FCYC:
+    case TIMER_TSC:
+	start_counter();
+	for (i = 0; i < n; i++)
+	    f(argp);
+	return get_counter()/(Mhz*1e6)/n;
+    case TIMER_ITIMER:
+	return ftimer_itimer(f, argp, n);
+    case TIMER_MONOTONIC:
+	return ftimer_monotonic(f, argp, n);
+    default:
+	return ftimer_gettod(f, argp, n);
+    }
+}
+
+/*
+ * fsecs_once - Return the running time of a single call of f
+ */
+double fsecs_once(fsecs_test_funct f, void *argp)
+{
+    return fsecs_reps(f, argp, 1);
+}
+
+static void do_nothing(void *argp)
 {
-#if USE_FCYC
-    double cycles = fcyc(f, argp);
-    return cycles/(Mhz*1e6);
-#elif USE_ITIMER
-    return ftimer_itimer(f, argp, 10);
-#elif USE_GETTOD
-    return ftimer_gettod(f, argp, 10);
-#endif 
 }
 
+/*
+ * fsecs_resolution - Return the smallest nonzero time that the timer
+ *     reports for an empty function, i.e. its tick plus the cost of
+ *     reading it, or 1 ms for a timer that hardly ever ticks during
+ *     one. Measured once, on the first call.
+ */
+double fsecs_resolution(void)
+{
+    static double res = 0;
+    double t;
+    int i, seen = 0;
+
+    if (res > 0)
+	return res;
+    for (i = 0; seen < 100 && i < 1000000; i++) {
+	if ((t = fsecs_once(do_nothing, NULL)) > 0) {
+	    if (res == 0 || t < res)
+		res = t;
+	    seen++;
+	}
+    }
+    if (seen < 100)
+	res = 1e-3;
+    return res;
+}
 
+/*
+ * fsecs - Return the running time of a function f (in seconds)
+ */
+double fsecs(fsecs_test_funct f, void *argp) 
+{
+    switch (timer) {
+    case TIMER_FCYC:
+    case TIMER_TSC:
+	return fcyc(f, argp)/(Mhz*1e6);
+    case TIMER_ITIMER:
+	return ftimer_itimer(f, argp, 10);
+    case TIMER_MONOTONIC:
+	return ftimer_monotonic(f, argp, 10);
+    default:
+	return ftimer_gettod(f, argp, 10);
+    }
+}
@@ -2,3 +2,16 @@ typedef void (*fsecs_test_funct)(void *);
 
 void init_fsecs(void);
 double fsecs(fsecs_test_funct f, void *argp);
+
+/* Time a single call of f, or n calls together (returning the average
+   time per call), with the selected timer */
+double fsecs_once(fsecs_test_funct f, void *argp);
+double fsecs_reps(fsecs_test_funct f, void *argp, int n);
+
+/* Smallest nonzero time the selected timer can report */
+double fsecs_resolution(void);
+
+/* Select the timing method at runtime (returns 0 if unknown) */
+int set_fsecs_timer(char *name);
+char *fsecs_timer_names(void);
+char *fsecs_timer_name(void);
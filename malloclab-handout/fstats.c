@@ -0,0 +1,146 @@
+/*
+ * fstats.c - Robust statistics over repeated timing samples
+ *
+ * Where fcyc reports the minimum of the K best samples, these
+ * routines keep every sample so that variance can be reported and
+ * two builds can be compared with a significance test:
+ *
+ *  - Outliers (interrupts, migrations, page faults) are dropped using
+ *    the median absolute deviation, which they cannot inflate.
+ *  - The center is the median, with a distribution-free 95%
+ *    confidence interval taken from the order statistics.
+ *  - Two sets of samples are compared with the Mann-Whitney U test,
+ *    which does not assume that timings are normally distributed.
+ */
+#include <stdlib.h>
+#include <math.h>
+
+#include "fstats.h"
+
+#define OUTLIER_Z 3.5  /* modified z-score beyond which a sample is dropped */
+#define Z_95 1.959964  /* two-sided 95% normal quantile */
+#define MIN_TICKS 1000 /* a sample lasts this many timer resolutions */
+#define MAX_REPS (1 << 20)
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* median of sorted vals */
+static double median(double *vals, int n)
+{
+    return (n % 2) ? vals[n/2] : (vals[n/2 - 1] + vals[n/2]) / 2;
+}
+
+void fstats_sample(fsecs_test_funct f, void *argp, int warmup, 
+		   double *vals, int n)
+{
+    double min_secs = MIN_TICKS * fsecs_resolution();
+    int i, reps;
+
+    for (i = 0; i < warmup; i++)
+	f(argp);
+
+    /* Calls that are too quick to time are repeated in each sample */
+    for (reps = 1; reps < MAX_REPS; reps *= 2)
+	if (fsecs_reps(f, argp, reps) * reps >= min_secs)
+	    break;
+    for (i = 0; i < n; i++)
+	vals[i] = fsecs_reps(f, argp, reps);
+}
+
+int fstats_summarize(double *vals, int n, fstats_t *s)
+{
+    double *dev, med, mad;
+    int i, kept, lo, hi;
+
+    qsort(vals, n, sizeof(double), cmp_double);
+    med = median(vals, n);
+
+    /* Median absolute deviation */
+    if ((dev = malloc(n * sizeof(double))) == NULL)
+	return 0;
+    for (i = 0; i < n; i++)
+	dev[i] = fabs(vals[i] - med);
+    qsort(dev, n, sizeof(double), cmp_double);
+    mad = median(dev, n);
+    free(dev);
+
+    /* Keep samples whose modified z-score 0.6745*|x-med|/MAD is small */
+    kept = 0;
+    for (i = 0; i < n; i++) {
+	if (mad == 0 || 0.6745 * fabs(vals[i] - med) / mad <= OUTLIER_Z)
+	    vals[kept++] = vals[i];
+    }
+
+    s->n = kept;
+    s->outliers = n - kept;
+    s->median = median(vals, kept);
+    s->min = vals[0];
+    s->max = vals[kept - 1];
+
+    /* 1-based ranks floor(n/2 - 1.96*sqrt(n)/2) and 
+       ceil(1 + n/2 + 1.96*sqrt(n)/2) bound the median with 95% 
+       confidence; lo and hi are those ranks less one */
+    lo = (int)floor(kept / 2.0 - Z_95 * sqrt(kept) / 2) - 1;
+    hi = (int)ceil(kept / 2.0 + Z_95 * sqrt(kept) / 2);
+    s->ci_lo = vals[lo < 0 ? 0 : lo];
+    s->ci_hi = vals[hi > kept - 1 ? kept - 1 : hi];
+    return kept;
+}
+
+double fstats_compare(double *a, int na, double *b, int nb)
+{
+    double *all, u, mu, sigma, ties = 0, rank_a = 0, avg, z;
+    int *from_a, i, j, k, m, n = na + nb;
+
+    if (na == 0 || nb == 0)
+	return 1.0;
+    all = malloc(n * sizeof(double));
+    from_a = malloc(n * sizeof(int));
+    if (all == NULL || from_a == NULL)
+	return 1.0;
+
+    /* Sort the pooled samples, remembering which set each came from */
+    for (i = 0; i < na; i++)
+	all[i] = a[i];
+    for (i = 0; i < nb; i++)
+	all[na + i] = b[i];
+    qsort(all, n, sizeof(double), cmp_double);
+    for (i = 0; i < n; i++)
+	from_a[i] = 0;
+    for (i = 0; i < na; i++) {
+	/* Mark the first unmarked pooled slot holding a[i] */
+	for (j = 0; j < n; j++) {
+	    if (all[j] == a[i] && !from_a[j]) {
+		from_a[j] = 1;
+		break;
+	    }
+	}
+    }
+
+    /* Sum the ranks of a, giving tied values their average rank */
+    for (i = 0; i < n; i = j) {
+	for (j = i; j < n && all[j] == all[i]; j++)
+	    ;
+	k = j - i;
+	avg = (i + 1 + j) / 2.0;    /* ranks i+1..j are tied */
+	for (m = i; m < j; m++)
+	    if (from_a[m])
+		rank_a += avg;
+	ties += (double)k * k * k - k;
+    }
+    free(all);
+    free(from_a);
+
+    /* Normal approximation to the distribution of U, tie corrected */
+    u = rank_a - na * (na + 1) / 2.0;
+    mu = na * (double)nb / 2;
+    sigma = sqrt(na * (double)nb / 12 * ((n + 1) - ties / ((double)n * (n - 1))));
+    if (sigma == 0)
+	return 1.0;
+    z = fabs(u - mu) / sigma;
+    return erfc(z / sqrt(2.0));
+}
@@ -0,0 +1,43 @@
+/*
+ * fstats.h - prototypes for the routines in fstats.c that summarize
+ *     repeated timing samples and compare two sets of samples
+ */
+#ifndef __FSTATS_H_
+#define __FSTATS_H_
+
+#include "fsecs.h"
+
+/* Summary of a set of timing samples */
+typedef struct {
+    int n;            /* number of samples kept */
+    int outliers;     /* number of samples discarded as outliers */
+    double median;
+    double ci_lo;     /* 95% confidence interval of the median */
+    double ci_hi;
+    double min;
+    double max;
+} fstats_t;
+
+/* 
+ * fstats_sample - Call f warmup times untimed, then time it for each 
+ *     of the n entries of vals. A call that takes less than a thousand
+ *     times the timer's resolution is repeated within each sample, 
+ *     and the entry is the time per call.
+ */
+void fstats_sample(fsecs_test_funct f, void *argp, int warmup, 
+		   double *vals, int n);
+
+/* 
+ * fstats_summarize - Sort vals, discard outliers (modified z-score 
+ *     above 3.5), and summarize the rest. Returns the number kept, 
+ *     which are moved to the front of vals.
+ */
+int fstats_summarize(double *vals, int n, fstats_t *s);
+
+/* 
+ * fstats_compare - Mann-Whitney U test of whether samples a and b 
+ *     come from the same distribution. Returns the two-sided p-value.
+ */
+double fstats_compare(double *a, int na, double *b, int nb);
+
+#endif /* __FSTATS_H_ */
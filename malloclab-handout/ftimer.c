@@ -7,8 +7,10 @@
  * Function timers that estimate the running time (in seconds) of a function f.
  *    ftimer_itimer: version that uses the interval timer
  *    ftimer_gettod: version that uses gettimeofday
+ *    ftimer_monotonic: version that uses clock_gettime
  */
 #include <stdio.h>
+#include <time.h>
 #include <sys/time.h>
 #include "ftimer.h"
 
@@ -52,6 +54,26 @@ double ftimer_gettod(ftimer_test_funct f, void *argp, int n)
     return (1E-3*diff);
 }
 
+/* 
+ * ftimer_monotonic - Use clock_gettime(CLOCK_MONOTONIC_RAW) to 
+ * estimate the running time of f(argp). Return the average of n runs.
+ */
+double ftimer_monotonic(ftimer_test_funct f, void *argp, int n)
+{
+    int i;
+    struct timespec sts, ets;
+#ifdef CLOCK_MONOTONIC_RAW
+    clockid_t clk = CLOCK_MONOTONIC_RAW;
+#else
+    clockid_t clk = CLOCK_MONOTONIC;
+#endif
+
+    clock_gettime(clk, &sts);
+    for (i = 0; i < n; i++) 
+	f(argp);
+    clock_gettime(clk, &ets);
+    return ((ets.tv_sec - sts.tv_sec) + 1E-9*(ets.tv_nsec - sts.tv_nsec)) / n;
+}
 
 /*
  * Routines for manipulating the Unix interval timer
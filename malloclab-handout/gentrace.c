@@ -0,0 +1,520 @@
+/*
+ * gentrace.c - Generate synthetic allocator stress traces for mdriver
+ *
+ * usage: gentrace [-b] [-s <scale>] [-o <outfile>] <paramfile>
+ *
+ * The parameter file holds "key = value" lines (# starts a comment).
+ * Keys given before the first [phase] line set the defaults; each
+ * [phase] line then starts a new phase that inherits the settings of
+ * the phase before it, so a workload can change its behavior midway:
+ *
+ *   seed           - random seed; the same file always gives the same trace
+ *   ops            - number of requests to generate in the phase
+ *   live_bytes     - target live heap size; frees are forced above it
+ *   size_dist      - uniform | powerlaw | bimodal
+ *   size_min, size_max - request size bounds (uniform, powerlaw)
+ *   size_alpha     - exponent of the power law, p(s) ~ s^-alpha
+ *   small_size, large_size, small_frac - the two modes of bimodal,
+ *                    and the fraction of requests that are small
+ *   lifetime_dist  - exponential | uniform | constant
+ *   lifetime_mean  - mean block lifetime, in requests
+ *   realloc_frac   - fraction of requests that realloc a live block
+ *   realloc_growth - factor by which a realloc changes the block size
+ *   realloc_max    - upper bound on the size of a realloced block
+ *
+ * Whatever is still live at the end is freed, so the trace is
+ * balanced like the -bal.rep traces. -s multiplies ops and live_bytes
+ * of every phase, for scaling experiments. The output is a .rep text
+ * trace, or the binary format of tracefmt.h with -b.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <limits.h>
+
+#include "tracefmt.h"
+
+#define MAXLINE    1024 /* max line length in the parameter file */
+#define MAXPHASES  64   /* max number of [phase] sections */
+
+/* Size and lifetime distributions */
+enum { DIST_UNIFORM, DIST_POWERLAW, DIST_BIMODAL,
+       DIST_EXPONENTIAL, DIST_CONSTANT };
+
+/* The parameters of one phase of the workload */
+typedef struct {
+    double ops;            /* requests to generate */
+    double live_bytes;     /* target live heap size */
+    int size_dist;         /* DIST_UNIFORM, DIST_POWERLAW, DIST_BIMODAL */
+    int size_min;
+    int size_max;
+    double size_alpha;
+    int small_size;
+    int large_size;
+    double small_frac;
+    int life_dist;         /* DIST_EXPONENTIAL, DIST_UNIFORM, DIST_CONSTANT */
+    double life_mean;
+    double realloc_frac;
+    double realloc_growth;
+    int realloc_max;
+} phase_t;
+
+/* A live block that is waiting to be freed */
+typedef struct {
+    long death;            /* request number at which to free it */
+    int id;
+} pending_t;
+
+/********************
+ * Global variables
+ *******************/
+static unsigned long long rng_state;  /* state of the random generator */
+
+static phase_t phases[MAXPHASES];
+static int num_phases = 0;
+
+/* The generated requests */
+static tracerec_t *ops = NULL;
+static long num_ops = 0, max_ops = 0;
+
+/* Per-id block state */
+static int *sizes = NULL;      /* current size of each id */
+static int *live_pos = NULL;   /* position in live_ids, or -1 if free */
+static long num_ids = 0, max_ids = 0;
+
+/* Ids of the live blocks, for picking realloc victims */
+static int *live_ids = NULL;
+static long num_live = 0;
+
+/* Min-heap of live blocks, ordered by time of death */
+static pending_t *heap = NULL;
+static long heap_len = 0, heap_max = 0;
+
+static double live_bytes = 0, peak_bytes = 0;
+
+/********************
+ * Helper routines
+ *******************/
+
+static void app_error(char *msg)
+{
+    fprintf(stderr, "gentrace: %s\n", msg);
+    exit(1);
+}
+
+static void *xrealloc(void *p, size_t size)
+{
+    if ((p = realloc(p, size)) == NULL)
+	app_error("out of memory");
+    return p;
+}
+
+/*
+ * rand_double - Return a uniform random number in [0, 1). Uses
+ *     splitmix64 rather than rand() so that traces are reproducible
+ *     on every platform.
+ */
+static double rand_double(void)
+{
+    unsigned long long z = (rng_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * rand_size - Draw a request size from the phase's size distribution
+ */
+static int rand_size(phase_t *p)
+{
+    double u = rand_double(), lo, hi, a;
+    int base;
+
+    switch (p->size_dist) {
+    case DIST_POWERLAW:
+	/* Inverse CDF of p(s) ~ s^-alpha truncated to [size_min, size_max] */
+	lo = p->size_min;
+	hi = p->size_max;
+	a = p->size_alpha;
+	if (fabs(a - 1.0) < 1e-9)
+	    return (int)(lo * pow(hi / lo, u));
+	return (int)pow(pow(lo, 1 - a) + u * (pow(hi, 1 - a) - pow(lo, 1 - a)),
+			1 / (1 - a));
+
+    case DIST_BIMODAL:
+	/* Each mode is spread +-25% around its size */
+	base = (u < p->small_frac) ? p->small_size : p->large_size;
+	return (int)(base * (0.75 + 0.5 * rand_double())) + 1;
+
+    default: /* DIST_UNIFORM */
+	return p->size_min + (int)(u * (p->size_max - p->size_min + 1));
+    }
+}
+
+/*
+ * rand_lifetime - Draw a block lifetime (in requests) from the phase's
+ *     lifetime distribution
+ */
+static long rand_lifetime(phase_t *p)
+{
+    switch (p->life_dist) {
+    case DIST_UNIFORM:
+	return 1 + (long)(rand_double() * 2 * p->life_mean);
+    case DIST_CONSTANT:
+	return (long)p->life_mean;
+    default: /* DIST_EXPONENTIAL */
+	return 1 + (long)(-log(1.0 - rand_double()) * p->life_mean);
+    }
+}
+
+/*
+ * emit - Append a request to the trace
+ */
+static void emit(int type, int id, int size)
+{
+    if (num_ops == max_ops) {
+	max_ops = max_ops ? 2 * max_ops : 1 << 16;
+	ops = xrealloc(ops, max_ops * sizeof(tracerec_t));
+    }
+    ops[num_ops].type = type;
+    ops[num_ops].index = id;
+    ops[num_ops].size = (type == 'f') ? 0 : size;
+    num_ops++;
+    if (num_ops > INT_MAX)
+	app_error("too many requests for the trace format");
+}
+
+/*
+ * heap_push, heap_pop - Maintain the min-heap of pending frees
+ */
+static void heap_push(long death, int id)
+{
+    long i = heap_len++;
+    pending_t tmp;
+
+    if (heap_len > heap_max) {
+	heap_max = heap_max ? 2 * heap_max : 1 << 16;
+	heap = xrealloc(heap, heap_max * sizeof(pending_t));
+    }
+    heap[i].death = death;
+    heap[i].id = id;
+    while (i > 0 && heap[(i-1)/2].death > heap[i].death) {
+	tmp = heap[i];
+	heap[i] = heap[(i-1)/2];
+	heap[(i-1)/2] = tmp;
+	i = (i-1)/2;
+    }
+}
+
+static int heap_pop(void)
+{
+    int id = heap[0].id;
+    long i = 0, c;
+    pending_t tmp;
+
+    heap[0] = heap[--heap_len];
+    while ((c = 2*i + 1) < heap_len) {
+	if (c + 1 < heap_len && heap[c+1].death < heap[c].death)
+	    c++;
+	if (heap[i].death <= heap[c].death)
+	    break;
+	tmp = heap[i];
+	heap[i] = heap[c];
+	heap[c] = tmp;
+	i = c;
+    }
+    return id;
+}
+
+/*
+ * do_alloc, do_free, do_realloc - Generate one request and update
+ *     the state of the simulated heap
+ */
+static void do_alloc(phase_t *p, long now)
+{
+    int id, size = rand_size(p);
+
+    if (size < 1)
+	size = 1;
+    if (num_ids == max_ids) {
+	max_ids = max_ids ? 2 * max_ids : 1 << 16;
+	sizes = xrealloc(sizes, max_ids * sizeof(int));
+	live_pos = xrealloc(live_pos, max_ids * sizeof(int));
+	live_ids = xrealloc(live_ids, max_ids * sizeof(int));
+    }
+    id = num_ids++;
+    sizes[id] = size;
+    live_pos[id] = num_live;
+    live_ids[num_live++] = id;
+    live_bytes += size;
+    if (live_bytes > peak_bytes)
+	peak_bytes = live_bytes;
+    heap_push(now + rand_lifetime(p), id);
+    emit('a', id, size);
+}
+
+static void do_free(void)
+{
+    int id = heap_pop();
+    int last = live_ids[--num_live];
+
+    live_ids[live_pos[id]] = last;
+    live_pos[last] = live_pos[id];
+    live_pos[id] = -1;
+    live_bytes -= sizes[id];
+    emit('f', id, 0);
+}
+
+static void do_realloc(phase_t *p)
+{
+    int id = live_ids[(long)(rand_double() * num_live)];
+    double newsize = sizes[id] * p->realloc_growth;
+
+    if (newsize > p->realloc_max)
+	newsize = p->realloc_max;
+    if (newsize < 1)
+	newsize = 1;
+    live_bytes += (int)newsize - sizes[id];
+    if (live_bytes > peak_bytes)
+	peak_bytes = live_bytes;
+    sizes[id] = (int)newsize;
+    emit('r', id, sizes[id]);
+}
+
+/*
+ * generate - Generate the requests for every phase, then free
+ *     whatever is still live
+ */
+static void generate(void)
+{
+    int i;
+    long n, now = 0;
+    phase_t *p;
+
+    for (i = 0; i < num_phases; i++) {
+	p = &phases[i];
+	for (n = 0; n < (long)p->ops; n++, now++) {
+	    if (heap_len > 0 &&
+		(heap[0].death <= now || live_bytes >= p->live_bytes))
+		do_free();
+	    else if (num_live > 0 && rand_double() < p->realloc_frac)
+		do_realloc(p);
+	    else
+		do_alloc(p, now);
+	}
+    }
+    while (heap_len > 0)
+	do_free();
+}
+
+/*******************************
+ * Parameter file and trace I/O
+ ******************************/
+
+/*
+ * set_param - Set one key of phase p from the parameter file
+ */
+static void set_param(phase_t *p, char *key, char *val, int linenum)
+{
+    char msg[3*MAXLINE];
+
+    if (!strcmp(key, "seed"))
+	rng_state = strtoull(val, NULL, 0);
+    else if (!strcmp(key, "ops"))
+	p->ops = atof(val);
+    else if (!strcmp(key, "live_bytes"))
+	p->live_bytes = atof(val);
+    else if (!strcmp(key, "size_min"))
+	p->size_min = atoi(val);
+    else if (!strcmp(key, "size_max"))
+	p->size_max = atoi(val);
+    else if (!strcmp(key, "size_alpha"))
+	p->size_alpha = atof(val);
+    else if (!strcmp(key, "small_size"))
+	p->small_size = atoi(val);
+    else if (!strcmp(key, "large_size"))
+	p->large_size = atoi(val);
+    else if (!strcmp(key, "small_frac"))
+	p->small_frac = atof(val);
+    else if (!strcmp(key, "lifetime_mean"))
+	p->life_mean = atof(val);
+    else if (!strcmp(key, "realloc_frac"))
+	p->realloc_frac = atof(val);
+    else if (!strcmp(key, "realloc_growth"))
+	p->realloc_growth = atof(val);
+    else if (!strcmp(key, "realloc_max"))
+	p->realloc_max = atoi(val);
+    else if (!strcmp(key, "size_dist") && !strcmp(val, "uniform"))
+	p->size_dist = DIST_UNIFORM;
+    else if (!strcmp(key, "size_dist") && !strcmp(val, "powerlaw"))
+	p->size_dist = DIST_POWERLAW;
+    else if (!strcmp(key, "size_dist") && !strcmp(val, "bimodal"))
+	p->size_dist = DIST_BIMODAL;
+    else if (!strcmp(key, "lifetime_dist") && !strcmp(val, "exponential"))
+	p->life_dist = DIST_EXPONENTIAL;
+    else if (!strcmp(key, "lifetime_dist") && !strcmp(val, "uniform"))
+	p->life_dist = DIST_UNIFORM;
+    else if (!strcmp(key, "lifetime_dist") && !strcmp(val, "constant"))
+	p->life_dist = DIST_CONSTANT;
+    else {
+	sprintf(msg, "line %d: bad parameter '%s = %s'", linenum, key, val);
+	app_error(msg);
+    }
+}
+
+/*
+ * read_params - Read the parameter file into phases[]
+ */
+static void read_params(char *filename)
+{
+    FILE *f;
+    char line[MAXLINE], key[MAXLINE], val[MAXLINE];
+    char msg[2*MAXLINE];
+    char *s;
+    int linenum = 0;
+    phase_t defaults = {
+	10000,          /* ops */
+	1 << 20,        /* live_bytes */
+	DIST_UNIFORM,   /* size_dist */
+	1, 4096,        /* size_min, size_max */
+	1.5,            /* size_alpha */
+	32, 4096, 0.9,  /* small_size, large_size, small_frac */
+	DIST_EXPONENTIAL, 1000, /* life_dist, life_mean */
+	0.0, 1.5, 1 << 20,      /* realloc_frac, realloc_growth, realloc_max */
+    };
+    phase_t *cur = &defaults;
+
+    if ((f = fopen(filename, "r")) == NULL) {
+	perror(filename);
+	exit(1);
+    }
+    while (fgets(line, MAXLINE, f) != NULL) {
+	linenum++;
+	if ((s = strchr(line, '#')) != NULL)
+	    *s = '\0';
+	if (sscanf(line, " [%[^]]]", key) == 1) {
+	    if (strcmp(key, "phase") != 0 || num_phases == MAXPHASES) {
+		sprintf(msg, "line %d: bad section [%s]", linenum, key);
+		app_error(msg);
+	    }
+	    phases[num_phases] = *cur;
+	    cur = &phases[num_phases++];
+	    continue;
+	}
+	if ((s = strchr(line, '=')) == NULL) {
+	    if (sscanf(line, " %s", key) == 1) {
+		sprintf(msg, "line %d: expected key = value", linenum);
+		app_error(msg);
+	    }
+	    continue;
+	}
+	*s = ' ';
+	if (sscanf(line, " %s %s", key, val) != 2) {
+	    sprintf(msg, "line %d: expected key = value", linenum);
+	    app_error(msg);
+	}
+	set_param(cur, key, val, linenum);
+    }
+    fclose(f);
+
+    /* A file without [phase] sections describes a single phase */
+    if (num_phases == 0)
+	phases[num_phases++] = defaults;
+}
+
+/*
+ * write_trace - Write the trace as text (.rep) or in binary
+ */
+static void write_trace(FILE *out, int binary)
+{
+    tracehdr_t hdr;
+    long i;
+
+    hdr.sugg_heapsize = (peak_bytes > INT_MAX) ? INT_MAX : (int)peak_bytes;
+    hdr.num_ids = num_ids;
+    hdr.num_ops = num_ops;
+    hdr.weight = 1;
+
+    if (binary) {
+	if (fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_LEN, out) != TRACE_MAGIC_LEN ||
+	    fwrite(&hdr, sizeof(hdr), 1, out) != 1 ||
+	    fwrite(ops, sizeof(tracerec_t), num_ops, out) != (size_t)num_ops)
+	    app_error("write error");
+	return;
+    }
+
+    fprintf(out, "%d\n%d\n%d\n%d\n", (int)hdr.sugg_heapsize,
+	    (int)hdr.num_ids, (int)hdr.num_ops, (int)hdr.weight);
+    for (i = 0; i < num_ops; i++) {
+	if (ops[i].type == 'f')
+	    fprintf(out, "f %d\n", (int)ops[i].index);
+	else
+	    fprintf(out, "%c %d %d\n", (char)ops[i].type,
+		    (int)ops[i].index, (int)ops[i].size);
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: gentrace [-hb] [-s <scale>] [-o <file>] <paramfile>\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-b         Write a binary trace.\n");
+    fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-o <file>  Write the trace to <file> (default stdout).\n");
+    fprintf(stderr, "\t-s <scale> Multiply ops and live_bytes of every phase.\n");
+}
+
+int main(int argc, char **argv)
+{
+    int c, i, binary = 0;
+    double scale = 1.0;
+    char *outfile = NULL;
+    FILE *out = stdout;
+
+    rng_state = 1;
+    while ((c = getopt(argc, argv, "hbs:o:")) != -1) {
+	switch (c) {
+	case 'b':
+	    binary = 1;
+	    break;
+	case 's':
+	    scale = atof(optarg);
+	    break;
+	case 'o':
+	    outfile = optarg;
+	    break;
+	case 'h':
+	    usage();
+	    exit(0);
+	default:
+	    usage();
+	    exit(1);
+	}
+    }
+    if (optind != argc - 1 || scale <= 0) {
+	usage();
+	exit(1);
+    }
+
+    read_params(argv[optind]);
+    for (i = 0; i < num_phases; i++) {
+	phases[i].ops *= scale;
+	phases[i].live_bytes *= scale;
+	if (phases[i].size_min < 1 || phases[i].size_max < phases[i].size_min)
+	    app_error("need 1 <= size_min <= size_max");
+    }
+
+    generate();
+
+    if (outfile && (out = fopen(outfile, binary ? "wb" : "w")) == NULL) {
+	perror(outfile);
+	exit(1);
+    }
+    write_trace(out, binary);
+    if (fclose(out) != 0)
+	app_error("write error");
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * hist.c - Log-linear (HDR-style) histograms for latency measurements
+ *
+ * Values below HIST_SUB_COUNT get a bucket each. Above that, each
+ * power of two [2^e, 2^(e+1)) is divided into HIST_SUB_COUNT equal
+ * buckets, so every recorded value is known to within 1/HIST_SUB_COUNT
+ * of itself while the whole histogram stays a fixed, small size.
+ */
+#include <string.h>
+#include "hist.h"
+
+/*
+ * bucket_of - Map a value to its bucket index
+ */
+static int bucket_of(unsigned long long val)
+{
+    int e;
+
+    if (val < HIST_SUB_COUNT)
+	return (int)val;
+    e = 63 - __builtin_clzll(val);
+    if (e >= HIST_MAX_BITS)   /* 2^HIST_MAX_BITS and up share the last one */
+	return HIST_BUCKETS - 1;
+    return (e - HIST_SUB_BITS + 1) * HIST_SUB_COUNT + 
+	(int)((val >> (e - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1));
+}
+
+/*
+ * bucket_top - Return the largest value that maps to bucket b
+ */
+static double bucket_top(int b)
+{
+    int e, sub;
+
+    if (b < HIST_SUB_COUNT)
+	return b;
+    e = b / HIST_SUB_COUNT + HIST_SUB_BITS - 1;
+    sub = b % HIST_SUB_COUNT;
+    return (double)(((unsigned long long)(HIST_SUB_COUNT + sub + 1) 
+		     << (e - HIST_SUB_BITS)) - 1);
+}
+
+void hist_reset(hist_t *h)
+{
+    memset(h, 0, sizeof(hist_t));
+}
+
+void hist_add(hist_t *h, unsigned long long val)
+{
+    h->counts[bucket_of(val)]++;
+    h->total++;
+    if (val > h->max)
+	h->max = val;
+}
+
+double hist_quantile(hist_t *h, double q)
+{
+    unsigned long long rank, seen = 0;
+    double top;
+    int b;
+
+    if (h->total == 0)
+	return 0.0;
+    rank = (unsigned long long)(q * h->total + 0.5);
+    if (rank < 1)
+	rank = 1;
+    for (b = 0; b < HIST_BUCKETS; b++) {
+	seen += h->counts[b];
+	if (seen >= rank) {
+	    if (b == HIST_BUCKETS - 1)
+		return (double)h->max;
+	    top = bucket_top(b);
+	    /* Never report more than was actually seen */
+	    return (top < h->max) ? top : (double)h->max;
+	}
+    }
+    return (double)h->max;
+}
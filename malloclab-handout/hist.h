@@ -0,0 +1,28 @@
+/*
+ * hist.h - prototypes for the log-linear latency histograms in hist.c
+ */
+#ifndef __HIST_H_
+#define __HIST_H_
+
+/* Each power of two is split into 2^HIST_SUB_BITS linear buckets */
+#define HIST_SUB_BITS 5
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40          /* values up to 2^40 ns (~18 min) */
+#define HIST_BUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+typedef struct {
+    unsigned long long counts[HIST_BUCKETS];
+    unsigned long long total;     /* number of recorded values */
+    unsigned long long max;       /* largest recorded value */
+} hist_t;
+
+/* Empty the histogram */
+void hist_reset(hist_t *h);
+
+/* Record one value */
+void hist_add(hist_t *h, unsigned long long val);
+
+/* Return the value at quantile q (0 < q <= 1), accurate to ~3% */
+double hist_quantile(hist_t *h, double q);
+
+#endif /* __HIST_H_ */
@@ -15,10 +15,28 @@
 #include <assert.h>
 #include <float.h>
 #include <time.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/utsname.h>
 
 #include "mm.h"
 #include "memlib.h"
 #include "fsecs.h"
+#include "fstats.h"
+#include "fperf.h"
+#include "fcache.h"
+#include "hist.h"
+#include "tracefmt.h"
+#include "allocator.h"
+#include "topology.h"
 #include "config.h"
 
 /**********************
@@ -30,6 +48,44 @@
 #define HDRLINES       4 /* number of header lines in a trace file */
 #define LINENUM(i) (i+5) /* cnvt trace request nums to linenums (origin 1) */
 
+/* Latency measurements (-L) */
+#define LATENCY_RUNS  10 /* number of timed replays of each trace */
+#define NUM_OPTYPES    3 /* ALLOC, FREE, and REALLOC */
+#define NUM_QUANTILES  4 /* p50, p99, p99.9, and max */
+
+/* Benchmark mode (-B) */
+#define MAX_BENCH_SAMPLES 256 /* max timed replays of each trace */
+#define BENCH_WARMUP        3 /* default untimed replays before sampling */
+#define BENCH_ALPHA      0.05 /* significance level for comparisons (-C) */
+
+/* Replays that touch the payloads (-x) */
+#define ACCESS_FRAC 0.25 /* default fraction of live blocks read */
+#define ACCESS_LINE   64 /* bytes between the payload reads */
+
+/* Cache-cold replays (-k) of each trace; the median is reported */
+#define COLD_RUNS      5
+#define COLD_MIN_TICKS 100  /* a cold sample lasts this many timer ticks */
+#define COLD_MAX_REPS  64   /* but repeats at most this many replays */
+
+/* Hardware event counts (-P) are averaged over this many replays */
+#define PERF_RUNS      3
+
+/* Default number of requests between heap timeline samples (-T) */
+#define TIMELINE_INTERVAL 100
+
+/* Machine-readable results (-o) and baseline comparison (-b) */
+#define MAX_FIELDS         40 /* max columns reported for one trace */
+#define MAX_META           16 /* max environment metadata entries */
+#define REGRESS_PCT       5.0 /* default regression threshold (-r) */
+#define REGRESS_STATUS      2 /* exit status if a regression is found */
+
+/* Max number of malloc packages compared side by side (-A) */
+#define MAX_ALLOCATORS 8
+
+/* Components of the performance index, weighted by -w */
+#define NUM_SCORES     4
+enum {SCORE_UTIL, SCORE_THRU, SCORE_LAT, SCORE_RSS};
+
 /* Returns true if p is ALIGNMENT-byte aligned */
 #define IS_ALIGNED(p)  ((((unsigned int)(p)) % ALIGNMENT) == 0)
 
@@ -70,6 +126,8 @@ typedef struct {
 typedef struct {
     trace_t *trace;  
     range_t *ranges;
+    int *order;      /* ids of the live blocks in allocation order (-x) */
+    int *pos;        /* index of each id in order */
 } speed_t;
 
 /* Summarizes the important stats for some malloc function on some trace */
@@ -81,10 +139,61 @@ typedef struct {
 
     /* defined only for the student malloc package */
     double util;     /* space utilization for this trace (always 0 for libc) */
+    double rss_util; /* peak live bytes / resident heap bytes (if scored) */
+
+    /* defined only when measuring latencies (-L) */
+    double lat[NUM_OPTYPES][NUM_QUANTILES]; /* ns, by request type */
+
+    /* defined only in benchmark mode (-B), where secs is the median */
+    fstats_t bench;                       /* summary of the samples */
+    double samples[MAX_BENCH_SAMPLES];    /* raw secs of each replay */
+
+    /* defined only when measuring cache-cold replays (-k) */
+    double cold_secs;  /* secs for one replay after flushing the caches */
+
+    /* defined only when simulating access to the payloads (-x) */
+    double access_secs;  /* secs for one replay that also uses the blocks */
+
+    /* defined only when accounting for the pages replay touches (-m) */
+    double minflt;   /* minor page faults during one replay */
+    double majflt;   /* major page faults during one replay */
+    double pages;    /* heap pages resident afterwards, or -1 if unknown */
+
+    /* defined only when counting hardware events (-P) */
+    double perf[FPERF_NUM_EVENTS];  /* events per op, or -1 if unknown */
 
     /* Note: secs and util are only defined if valid is true */
 } stats_t; 
 
+/* 
+ * A worker process running traces in parallel (-j) sends one of these 
+ * back to the parent for each trace it evaluates 
+ */
+typedef struct {
+    int tracenum;    /* index of the trace in the tracefiles array */
+    int errors;      /* number of errors found while evaluating it */
+    stats_t stats;   /* the results */
+} result_t;
+
+/* Results must fit in one atomic pipe write */
+typedef char result_fits_pipe_buf[(sizeof(result_t) <= PIPE_BUF) ? 1 : -1];
+
+/* One named value of a trace's results, NAN if it wasn't measured */
+typedef struct {
+    char name[32];
+    double val;
+} field_t;
+
+/* One entry of the environment metadata stored with the results */
+typedef struct {
+    char *key;
+    char val[MAXLINE];
+} meta_t;
+
+/* Evaluates a single trace file, filling in its stats */
+typedef void (*eval_trace_funct)(char *tracefile, int tracenum, 
+				 stats_t *stats);
+
 /********************
  * Global variables
  *******************/
@@ -92,6 +201,55 @@ int verbose = 0;        /* global flag for verbose output */
 static int errors = 0;  /* number of errs found when running student malloc */
 char msg[MAXLINE];      /* for whenever we need to compose an error message */
 
+/* The malloc package being evaluated */
+static allocator_t *alloc;
+
+/* Number of worker processes used to evaluate traces (-j) */
+static int num_jobs = 1;
+
+/* CPU to run on (-p) and NUMA node for the mm heap (-n), or -1 */
+static int pin_cpu = -1;
+static int mem_node = -1;
+
+/* If set, measure the latency of each individual request (-L) */
+static int measure_latency = 0;
+
+/* The quantiles reported for latencies, and their names */
+static double lat_quantiles[NUM_QUANTILES] = {0.50, 0.99, 0.999, 1.0};
+static char *lat_names[NUM_QUANTILES] = {"p50", "p99", "p99.9", "max"};
+static char *optype_names[NUM_OPTYPES] = {"malloc", "free", "realloc"};
+
+/* Benchmark mode: timed samples and warmup replays per trace (-B, -W) */
+static int bench_samples = 0;
+static int bench_warmup = BENCH_WARMUP;
+
+/* If nonzero, also time replays that write each block when it is
+   allocated and read access_frac of the live blocks every
+   access_interval requests (-x) */
+static int access_interval = 0;
+static double access_frac = ACCESS_FRAC;
+static volatile unsigned access_sink; /* keeps the reads from being elided */
+
+/* If set, count the page faults and resident heap pages of a replay
+   that starts with none of the heap resident (-m) */
+static int measure_vm = 0;
+
+/* If set, also time replays that start with cold caches (-k) */
+static int measure_cold = 0;
+
+/* If set, count hardware events during a replay of each trace (-P) */
+static int measure_perf = 0;
+
+/* Weights of the components of the performance index (-w) */
+static char *score_names[NUM_SCORES] = {"util", "thru", "lat", "rss"};
+static double score_weights[NUM_SCORES] = {
+    UTIL_WEIGHT, 1.0 - UTIL_WEIGHT, 0, 0
+};
+
+/* Heap timeline CSV output (-T), sampled every timeline_interval ops */
+static int timeline_fd = -1;
+static int timeline_interval = TIMELINE_INTERVAL;
+
 /* Directory where default tracefiles are found */
 static char tracedir[MAXLINE] = TRACEDIR;
 
@@ -113,6 +271,7 @@ static void clear_ranges(range_t **ranges);
 
 /* These functions read, allocate, and free storage for traces */
 static trace_t *read_trace(char *tracedir, char *filename);
+static void read_trace_binary(FILE *tracefile, char *path, trace_t *trace);
 static void free_trace(trace_t *trace);
 
 /* Routines for evaluating the correctness and speed of libc malloc */
@@ -125,8 +284,52 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges);
 static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges);
 static void eval_mm_speed(void *ptr);
 
+/* Samples the state of the mm heap as a trace is replayed */
+static void eval_mm_timeline(trace_t *trace, int tracenum, char *tracefile);
+
+/* Measures the latency of each request in a trace */
+static void eval_latency(trace_t *trace, stats_t *stats);
+static unsigned long long now_ns(void);
+
+/* These functions run a complete evaluation of one or more traces */
+static void eval_libc_trace(char *tracefile, int tracenum, stats_t *stats);
+static void eval_mm_trace(char *tracefile, int tracenum, stats_t *stats);
+static void eval_traces(eval_trace_funct eval, char **tracefiles, 
+			int num_tracefiles, stats_t *stats);
+static void eval_traces_parallel(eval_trace_funct eval, char **tracefiles, 
+				 int num_tracefiles, stats_t *stats);
+static void numa_sweep(char **tracefiles, int num_tracefiles);
+
 /* Various helper routines */
 static void printresults(int n, stats_t *stats);
+static void printperf(double *perf);
+static void printvm(double pages, double minflt, double majflt);
+static void printlatency(int n, stats_t *stats);
+static void printbench(int n, stats_t *stats);
+static void printslowdown(int n, stats_t *stats, char *label, 
+			  size_t offset);
+static void printmatrix(int n, int npkgs, allocator_t **pkgs, 
+			stats_t **pkg_stats);
+static double eval_speed(fsecs_test_funct f, void *argp, stats_t *stats);
+static void eval_perf(fsecs_test_funct f, void *argp, stats_t *stats);
+static double eval_cold(fsecs_test_funct f, void *argp);
+static double eval_access(speed_t *params);
+static void get_faults(double *minflt, double *majflt);
+static void eval_access_speed(void *ptr);
+static void save_samples(char *filename, char **tracefiles, int n, 
+			 stats_t *stats);
+static void compare_samples(char *filename, char **tracefiles, int n, 
+			    stats_t *stats);
+static int result_fields(stats_t *stats, field_t *fields);
+static int env_metadata(meta_t *meta, double perfindex);
+static void write_results(char *filename, char **tracefiles, int n, 
+			  int npkgs, allocator_t **pkgs, stats_t **pkg_stats,
+			  double perfindex);
+static int compare_baseline(char *filename, char **tracefiles, int n, 
+			    stats_t *stats, double threshold);
+static int parse_weights(char *spec);
+static double perf_index(int n, stats_t *mm_stats, stats_t *libc_stats, 
+			 double ref_thru, double *parts);
 static void usage(void);
 static void unix_error(char *msg);
 static void malloc_error(int tracenum, int opnum, char *msg);
@@ -137,28 +340,45 @@ static void app_error(char *msg);
  **************/
 int main(int argc, char **argv)
 {
-    int i;
+    int i, j;
     char c;
     char **tracefiles = NULL;  /* null-terminated array of trace file names */
     int num_tracefiles = 0;    /* the number of traces in that array */
-    trace_t *trace = NULL;     /* stores a single trace file in memory */
-    range_t *ranges = NULL;    /* keeps track of block extents for one trace */
     stats_t *libc_stats = NULL;/* libc stats for each trace */
     stats_t *mm_stats = NULL;  /* mm (i.e. student) stats for each trace */
-    speed_t speed_params;      /* input parameters to the xx_speed routines */ 
+    allocator_t *pkgs[MAX_ALLOCATORS+2]; /* every package evaluated... */
+    stats_t *pkg_stats[MAX_ALLOCATORS+2];/* ... and its stats */
+    int npkgs = 0;
+    allocator_t *others[MAX_ALLOCATORS]; /* compared with mm (-A) */
+    int num_others = 0;
+    char *tok, *save;
 
     int team_check = 1;  /* If set, check team structure (reset by -a) */
     int run_libc = 0;    /* If set, run libc malloc (set by -l) */
+    int measure_ref = 0; /* If set, libc's throughput is the cap (-M) */
+    int sweep_nodes = 0; /* If set, measure each CPU/memory node pair (-N) */
     int autograder = 0;  /* If set, emit summary info for autograder (-g) */
+    char *timer_name = NULL;   /* timing method given with -c */
+    unsigned long heap_mb;     /* heap size given with -H */
+    char *end;
+    char *save_file = NULL;    /* save benchmark samples here (-S) */
+    char *compare_file = NULL; /* compare with samples saved here (-C) */
+    char *output_file = NULL;  /* write results as JSON or CSV here (-o) */
+    char *baseline_file = NULL;/* check for regressions against this (-b) */
+    double threshold = REGRESS_PCT; /* regression threshold in % (-r) */
+    int regressions = 0;
 
     /* temporaries used to compute the performance index */
-    double secs, ops, util, avg_mm_util, avg_mm_throughput, p1, p2, perfindex;
+    double secs, ops, perfindex, parts[NUM_SCORES];
+    double ref_thru = AVG_LIBC_THRUPUT; /* throughput cap (-R, -M) */
+    char *ref_source = "config.h";
+    char *sep, *gap;
     int numcorrect;
     
     /* 
      * Read and interpret the command line arguments 
      */
-    while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF) {
+    while ((c = getopt(argc, argv, "f:t:j:T:i:H:c:B:W:S:C:o:b:r:w:R:A:p:n:x:hvVgalLPMkmN")) != EOF) {
         switch (c) {
 	case 'g': /* Generate summary info for the autograder */
 	    autograder = 1;
@@ -184,6 +404,150 @@ int main(int argc, char **argv)
         case 'l': /* Run libc malloc */
             run_libc = 1;
             break;
+	case 'A': /* Compare mm with these malloc packages */
+	    for (tok = strtok_r(optarg, ",", &save); tok; 
+		 tok = strtok_r(NULL, ",", &save)) {
+		for (i = 0; allocators[i].name != NULL; i++) {
+		    if (strcmp(tok, "all") && strcmp(tok, allocators[i].name))
+			continue;
+		    for (j = 0; j < num_others; j++)
+			if (others[j] == &allocators[i])
+			    break;
+		    if (j == num_others && strcmp(allocators[i].name, "mm") &&
+			num_others < MAX_ALLOCATORS)
+			others[num_others++] = &allocators[i];
+		    if (strcmp(tok, "all"))
+			break;
+		}
+		if (strcmp(tok, "all") && allocators[i].name == NULL) {
+		    fprintf(stderr, "Unknown malloc package \"%s\"\n", tok);
+		    usage();
+		    exit(1);
+		}
+	    }
+	    break;
+	case 'M': /* Measure libc's throughput and use it as the cap */
+	    measure_ref = 1;
+	    break;
+	case 'R': /* Reference throughput (ops/sec) */
+	    ref_thru = atof(optarg);
+	    ref_source = "-R";
+	    if (ref_thru <= 0) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'w': /* Weights of the performance index components */
+	    if (!parse_weights(optarg)) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'L': /* Report the latency of individual requests */
+	    measure_latency = 1;
+	    break;
+	case 'p': /* Pin the driver to this CPU */
+	    pin_cpu = atoi(optarg);
+	    if (pin_cpu < 0 || pin_cpu >= topo_num_cpus()) {
+		fprintf(stderr, "-p must be between 0 and %d\n", 
+			topo_num_cpus() - 1);
+		exit(1);
+	    }
+	    break;
+	case 'n': /* Put the mm heap on this NUMA node */
+	    mem_node = atoi(optarg);
+	    if (mem_node < 0) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'N': /* Measure the cost of remote NUMA memory */
+	    sweep_nodes = 1;
+	    break;
+	case 'x': /* Also time replays that access the payloads */
+	    access_interval = atoi(optarg);
+	    if ((tok = strchr(optarg, ':')) != NULL)
+		access_frac = atof(tok + 1);
+	    if (access_interval < 1 || access_frac <= 0 || access_frac > 1) {
+		fprintf(stderr, "-x takes <n>[:<frac>], with 0 < frac <= 1\n");
+		exit(1);
+	    }
+	    break;
+	case 'k': /* Also time cache-cold replays */
+	    measure_cold = 1;
+	    break;
+	case 'm': /* Count page faults and resident heap pages */
+	    measure_vm = 1;
+	    break;
+	case 'P': /* Count hardware events with perf_event_open */
+	    measure_perf = 1;
+	    break;
+	case 'T': /* Write a heap timeline for each trace to a CSV file */
+	    if ((timeline_fd = open(optarg, O_WRONLY | O_CREAT | O_TRUNC | 
+				    O_APPEND, 0644)) < 0)
+		unix_error("Could not open timeline file");
+	    break;
+	case 'i': /* Timeline sampling interval */
+	    timeline_interval = atoi(optarg);
+	    if (timeline_interval < 1) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'B': /* Benchmark mode: number of timed replays */
+	    bench_samples = atoi(optarg);
+	    if (bench_samples < 1 || bench_samples > MAX_BENCH_SAMPLES) {
+		fprintf(stderr, "-B must be between 1 and %d\n", 
+			MAX_BENCH_SAMPLES);
+		exit(1);
+	    }
+	    break;
+	case 'W': /* Benchmark mode: number of warmup replays */
+	    bench_warmup = atoi(optarg);
+	    break;
+	case 'S': /* Save benchmark samples */
+	    save_file = optarg;
+	    break;
+	case 'C': /* Compare with saved benchmark samples */
+	    compare_file = optarg;
+	    break;
+	case 'o': /* Write the results to a JSON or CSV file */
+	    output_file = optarg;
+	    break;
+	case 'b': /* Compare the results with a baseline CSV file */
+	    baseline_file = optarg;
+	    break;
+	case 'r': /* Regression threshold (percent) */
+	    threshold = atof(optarg);
+	    if (threshold < 0) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'c': /* Timing method */
+	    timer_name = optarg;
+	    if (!set_fsecs_timer(optarg)) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'H': /* Maximum heap size in MB */
+	    errno = 0;
+	    heap_mb = strtoul(optarg, &end, 10);
+	    if (errno || *end != '\0' || optarg[0] == '-' || heap_mb < 1 ||
+		heap_mb > (SIZE_MAX >> 20) || 
+		mem_set_max_heap((size_t)heap_mb << 20) < 0) {
+		usage();
+		exit(1);
+	    }
+	    break;
+	case 'j': /* Evaluate traces in this many worker processes */
+	    num_jobs = atoi(optarg);
+	    if (num_jobs < 1) {
+		usage();
+		exit(1);
+	    }
+	    break;
         case 'v': /* Print per-trace performance breakdown */
             verbose = 1;
             break;
@@ -235,13 +599,78 @@ int main(int argc, char **argv)
 	printf("Using default tracefiles in %s\n", tracedir);
     }
 
+    /* Workers that share a CPU slow each other down, which would skew 
+       the throughput they measure */
+    if (num_jobs > topo_num_cpus()) {
+	fprintf(stderr, "Warning: -j %d is more than the number of CPUs "
+		"(%d); using -j %d\n", num_jobs, topo_num_cpus(), 
+		topo_num_cpus());
+	num_jobs = topo_num_cpus();
+    }
+
+    /* Latency is scored relative to libc, so both must be measured */
+    if (score_weights[SCORE_LAT] > 0) {
+	if (!measure_ref) {
+	    fprintf(stderr, "Scoring latency (-w lat=...) requires -M\n");
+	    exit(1);
+	}
+	measure_latency = 1;
+    }
+
+    if ((save_file || compare_file) && bench_samples == 0) {
+	fprintf(stderr, "-S and -C require benchmark mode (-B)\n");
+	exit(1);
+    }
+
+    /* 
+     * The samples of -B and -k are single replays, which gettimeofday 
+     * and the interval timer are too coarse to tell apart, so use the 
+     * monotonic clock unless -c asked for a finer one
+     */
+    if ((bench_samples > 0 || measure_cold) && 
+	(!strcmp(fsecs_timer_name(), "gettod") || 
+	 !strcmp(fsecs_timer_name(), "itimer"))) {
+	if (timer_name != NULL) {
+	    fprintf(stderr, "-B and -k require the monotonic, tsc or fcyc "
+		    "timer, not %s\n", timer_name);
+	    exit(1);
+	}
+	set_fsecs_timer("monotonic");
+    }
+
+    /* Pin before calibrating the timers, whose rates may differ by CPU */
+    if (pin_cpu >= 0 && topo_pin_cpu(pin_cpu) < 0)
+	unix_error("Could not pin to the CPU given by -p");
+
     /* Initialize the timing package */
     init_fsecs();
 
+    /* Fill the cache flush buffer now, so that -j workers share it */
+    if (measure_cold) {
+	size_t bytes = fcache_init();
+	if (verbose)
+	    printf("Flushing %lu KB of cache before each cold replay.\n",
+		   (unsigned long)(bytes >> 10));
+    }
+
+    if (measure_perf && init_fperf() == 0) {
+	fprintf(stderr, "Warning: hardware event counters are unavailable "
+		"(check /proc/sys/kernel/perf_event_paranoid); ignoring -P\n");
+	measure_perf = 0;
+    }
+
+    if (timeline_fd >= 0) {
+	char *hdr = "trace,file,op,heap_bytes,live_bytes,"
+	    "free_blocks,largest_free\n";
+	if (write(timeline_fd, hdr, strlen(hdr)) < 0)
+	    unix_error("write failed on timeline file");
+    }
+
     /*
-     * Optionally run and evaluate the libc malloc package 
+     * Optionally run and evaluate the libc malloc package, either to
+     * display it (-l) or as the scoring reference (-M)
      */
-    if (run_libc) {
+    if (run_libc || measure_ref) {
 	if (verbose > 1)
 	    printf("\nTesting libc malloc\n");
 	
@@ -251,26 +680,32 @@ int main(int argc, char **argv)
 	    unix_error("libc_stats calloc in main failed");
 	
 	/* Evaluate the libc malloc package using the K-best scheme */
-	for (i=0; i < num_tracefiles; i++) {
-	    trace = read_trace(tracedir, tracefiles[i]);
-	    libc_stats[i].ops = trace->num_ops;
-	    if (verbose > 1)
-		printf("Checking libc malloc for correctness, ");
-	    libc_stats[i].valid = eval_libc_valid(trace, i);
-	    if (libc_stats[i].valid) {
-		speed_params.trace = trace;
-		if (verbose > 1)
-		    printf("and performance.\n");
-		libc_stats[i].secs = fsecs(eval_libc_speed, &speed_params);
-	    }
-	    free_trace(trace);
-	}
+	alloc = find_allocator("libc");
+	eval_traces(eval_libc_trace, tracefiles, num_tracefiles, libc_stats);
 
 	/* Display the libc results in a compact table */
-	if (verbose) {
+	if (run_libc && (verbose || measure_perf || measure_vm)) {
 	    printf("\nResults for libc malloc:\n");
 	    printresults(num_tracefiles, libc_stats);
 	}
+	if (run_libc && bench_samples) {
+	    printf("\nBenchmark for libc malloc:\n");
+	    printbench(num_tracefiles, libc_stats);
+	}
+	if (run_libc && measure_cold) {
+	    printf("\nCold vs. warm caches for libc malloc:\n");
+	    printslowdown(num_tracefiles, libc_stats, "cold", 
+			  offsetof(stats_t, cold_secs));
+	}
+	if (run_libc && access_interval) {
+	    printf("\nPayload access for libc malloc:\n");
+	    printslowdown(num_tracefiles, libc_stats, "access", 
+			  offsetof(stats_t, access_secs));
+	}
+	if (run_libc && measure_latency) {
+	    printf("\nLatency for libc malloc (ns):\n");
+	    printlatency(num_tracefiles, libc_stats);
+	}
     }
 
     /*
@@ -286,71 +721,130 @@ int main(int argc, char **argv)
     
     /* Initialize the simulated memory system in memlib.c */
     mem_init(); 
+    if (mem_node >= 0 && mem_bind_node(mem_node) < 0)
+	unix_error("Could not bind the heap to the NUMA node given by -n");
 
     /* Evaluate student's mm malloc package using the K-best scheme */
-    for (i=0; i < num_tracefiles; i++) {
-	trace = read_trace(tracedir, tracefiles[i]);
-	mm_stats[i].ops = trace->num_ops;
-	if (verbose > 1)
-	    printf("Checking mm_malloc for correctness, ");
-	mm_stats[i].valid = eval_mm_valid(trace, i, &ranges);
-	if (mm_stats[i].valid) {
-	    if (verbose > 1)
-		printf("efficiency, ");
-	    mm_stats[i].util = eval_mm_util(trace, i, &ranges);
-	    speed_params.trace = trace;
-	    speed_params.ranges = ranges;
-	    if (verbose > 1)
-		printf("and performance.\n");
-	    mm_stats[i].secs = fsecs(eval_mm_speed, &speed_params);
-	}
-	free_trace(trace);
-    }
+    alloc = find_allocator("mm");
+    eval_traces(eval_mm_trace, tracefiles, num_tracefiles, mm_stats);
 
     /* Display the mm results in a compact table */
-    if (verbose) {
+    gap = "\n";   /* a blank line comes before the first table only */
+    if (verbose || measure_perf || measure_vm) {
 	printf("\nResults for mm malloc:\n");
 	printresults(num_tracefiles, mm_stats);
 	printf("\n");
+	gap = "";
+    }
+    if (bench_samples) {
+	printf("%sBenchmark for mm malloc:\n", gap);
+	printbench(num_tracefiles, mm_stats);
+	printf("\n");
+	gap = "";
+	if (save_file)
+	    save_samples(save_file, tracefiles, num_tracefiles, mm_stats);
+	if (compare_file)
+	    compare_samples(compare_file, tracefiles, num_tracefiles, 
+			    mm_stats);
+    }
+    if (measure_cold) {
+	printf("%sCold vs. warm caches for mm malloc:\n", gap);
+	printslowdown(num_tracefiles, mm_stats, "cold", 
+		      offsetof(stats_t, cold_secs));
+	printf("\n");
+	gap = "";
+    }
+    if (access_interval) {
+	printf("%sPayload access for mm malloc (read %.0f%% of the live "
+	       "blocks every %d requests):\n", gap, access_frac * 100, 
+	       access_interval);
+	printslowdown(num_tracefiles, mm_stats, "access", 
+		      offsetof(stats_t, access_secs));
+	printf("\n");
+	gap = "";
+    }
+    if (measure_latency) {
+	printf("%sLatency for mm malloc (ns):\n", gap);
+	printlatency(num_tracefiles, mm_stats);
+	printf("\n");
+    }
+
+    /*
+     * Evaluate the packages that mm is compared with (-A)
+     */
+    pkgs[npkgs] = find_allocator("mm");
+    pkg_stats[npkgs++] = mm_stats;
+    if (libc_stats) {
+	pkgs[npkgs] = find_allocator("libc");
+	pkg_stats[npkgs++] = libc_stats;
+    }
+    for (j = 0; j < num_others; j++) {
+	alloc = others[j];
+	if (alloc == find_allocator("libc") && libc_stats)
+	    continue;
+	if (verbose > 1)
+	    printf("\nTesting %s\n", alloc->desc);
+	if ((pkg_stats[npkgs] = calloc(num_tracefiles, sizeof(stats_t))) 
+	    == NULL)
+	    unix_error("stats calloc in main failed");
+	eval_traces(alloc->uses_memlib ? eval_mm_trace : eval_libc_trace, 
+		    tracefiles, num_tracefiles, pkg_stats[npkgs]);
+	pkgs[npkgs++] = alloc;
+    }
+    if (num_others) {
+	printf("Comparison of malloc packages (util, Kops):\n");
+	printmatrix(num_tracefiles, npkgs, pkgs, pkg_stats);
+	printf("\n");
     }
 
+    if (sweep_nodes)
+	numa_sweep(tracefiles, num_tracefiles);
+
     /* 
      * Accumulate the aggregate statistics for the student's mm package 
      */
-    secs = 0;
-    ops = 0;
-    util = 0;
     numcorrect = 0;
     for (i=0; i < num_tracefiles; i++) {
-	secs += mm_stats[i].secs;
-	ops += mm_stats[i].ops;
-	util += mm_stats[i].util;
 	if (mm_stats[i].valid)
 	    numcorrect++;
     }
-    avg_mm_util = util/num_tracefiles;
+
+    /* With -M, libc's throughput on these traces replaces the cap */
+    if (measure_ref) {
+	secs = 0;
+	ops = 0;
+	for (i=0; i < num_tracefiles; i++) {
+	    if (libc_stats[i].valid) {
+		secs += libc_stats[i].secs;
+		ops += libc_stats[i].ops;
+	    }
+	}
+	if (secs > 0) {
+	    ref_thru = ops/secs;
+	    ref_source = "libc, measured";
+	}
+	else
+	    printf("Warning: could not measure libc; keeping the %s cap\n",
+		   ref_source);
+    }
 
     /* 
      * Compute and print the performance index 
      */
     if (errors == 0) {
-	avg_mm_throughput = ops/secs;
-
-	p1 = UTIL_WEIGHT * avg_mm_util;
-	if (avg_mm_throughput > AVG_LIBC_THRUPUT) {
-	    p2 = (double)(1.0 - UTIL_WEIGHT);
-	} 
-	else {
-	    p2 = ((double) (1.0 - UTIL_WEIGHT)) * 
-		(avg_mm_throughput/AVG_LIBC_THRUPUT);
+	perfindex = perf_index(num_tracefiles, mm_stats, libc_stats, 
+			       ref_thru, parts) * 100.0;
+	if (verbose || measure_ref || strcmp(ref_source, "config.h"))
+	    printf("Throughput cap = %.0f Kops (%s)\n", 
+		   ref_thru/1e3, ref_source);
+	printf("Perf index = ");
+	for (i = 0, sep = ""; i < NUM_SCORES; i++) {
+	    if (score_weights[i] > 0) {
+		printf("%s%.0f (%s)", sep, parts[i]*100, score_names[i]);
+		sep = " + ";
+	    }
 	}
-	
-	perfindex = (p1 + p2)*100.0;
-	printf("Perf index = %.0f (util) + %.0f (thru) = %.0f/100\n",
-	       p1*100, 
-	       p2*100, 
-	       perfindex);
-	
+	printf(" = %.0f/100\n", perfindex);
     }
     else { /* There were errors */
 	perfindex = 0.0;
@@ -362,7 +856,14 @@ int main(int argc, char **argv)
 	printf("perfidx:%.0f\n", perfindex);
     }
 
-    exit(0);
+    if (output_file)
+	write_results(output_file, tracefiles, num_tracefiles, 
+		      npkgs, pkgs, pkg_stats, perfindex);
+    if (baseline_file)
+	regressions = compare_baseline(baseline_file, tracefiles, 
+				       num_tracefiles, mm_stats, threshold);
+
+    exit(regressions ? REGRESS_STATUS : 0);
 }
 
 
@@ -478,6 +979,7 @@ static trace_t *read_trace(char *tracedir, char *filename)
     char type[MAXLINE];
     char path[MAXLINE];
     unsigned index, size;
+    char magic[TRACE_MAGIC_LEN];
     unsigned max_index = 0;
     unsigned op_index;
 
@@ -495,6 +997,16 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	sprintf(msg, "Could not open %s in read_trace", path);
 	unix_error(msg);
     }
+
+    /* Traces written by gentrace -b are in the binary format */
+    if (fread(magic, 1, TRACE_MAGIC_LEN, tracefile) == TRACE_MAGIC_LEN &&
+	memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LEN) == 0) {
+	read_trace_binary(tracefile, path, trace);
+	fclose(tracefile);
+	return trace;
+    }
+    rewind(tracefile);
+
     fscanf(tracefile, "%d", &(trace->sugg_heapsize)); /* not used */
     fscanf(tracefile, "%d", &(trace->num_ids));     
     fscanf(tracefile, "%d", &(trace->num_ops));     
@@ -554,6 +1066,71 @@ static trace_t *read_trace(char *tracedir, char *filename)
     return trace;
 }
 
+/*
+ * read_trace_binary - read the rest of a binary (tracefmt.h) trace file,
+ *     positioned just past the magic string, into trace
+ */
+static void read_trace_binary(FILE *tracefile, char *path, trace_t *trace)
+{
+    tracehdr_t hdr;
+    tracerec_t *recs;
+    int i;
+
+    if (fread(&hdr, sizeof(hdr), 1, tracefile) != 1) {
+	sprintf(msg, "Truncated header in binary trace %s", path);
+	app_error(msg);
+    }
+    trace->sugg_heapsize = hdr.sugg_heapsize;
+    trace->num_ids = hdr.num_ids;
+    trace->num_ops = hdr.num_ops;
+    trace->weight = hdr.weight;
+
+    if ((trace->ops = 
+	 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
+	unix_error("malloc 2 failed in read_trace_binary");
+    if ((trace->blocks = 
+	 (char **)malloc(trace->num_ids * sizeof(char *))) == NULL)
+	unix_error("malloc 3 failed in read_trace_binary");
+    if ((trace->block_sizes = 
+	 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
+	unix_error("malloc 4 failed in read_trace_binary");
+    if ((recs = 
+	 (tracerec_t *)malloc(trace->num_ops * sizeof(tracerec_t))) == NULL)
+	unix_error("malloc 5 failed in read_trace_binary");
+
+    if (fread(recs, sizeof(tracerec_t), trace->num_ops, tracefile) != 
+	(size_t)trace->num_ops) {
+	sprintf(msg, "Truncated binary trace %s", path);
+	app_error(msg);
+    }
+
+    for (i = 0; i < trace->num_ops; i++) {
+	if (recs[i].index < 0 || recs[i].index >= trace->num_ids) {
+	    sprintf(msg, "Bad index %d in binary trace %s", 
+		    (int)recs[i].index, path);
+	    app_error(msg);
+	}
+	switch (recs[i].type) {
+	case 'a':
+	    trace->ops[i].type = ALLOC;
+	    break;
+	case 'r':
+	    trace->ops[i].type = REALLOC;
+	    break;
+	case 'f':
+	    trace->ops[i].type = FREE;
+	    break;
+	default:
+	    printf("Bogus type character (%c) in tracefile %s\n", 
+		   (char)recs[i].type, path);
+	    exit(1);
+	}
+	trace->ops[i].index = recs[i].index;
+	trace->ops[i].size = recs[i].size;
+    }
+    free(recs);
+}
+
 /*
  * free_trace - Free the trace record and the three arrays it points
  *              to, all of which were allocated in read_trace().
@@ -589,7 +1166,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
     clear_ranges(ranges);
 
     /* Call the mm package's init function */
-    if (mm_init() < 0) {
+    if (alloc->init() < 0) {
 	malloc_error(tracenum, 0, "mm_init failed.");
 	return 0;
     }
@@ -604,7 +1181,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
         case ALLOC: /* mm_malloc */
 
 	    /* Call the student's malloc */
-	    if ((p = mm_malloc(size)) == NULL) {
+	    if ((p = alloc->malloc(size)) == NULL) {
 		malloc_error(tracenum, i, "mm_malloc failed.");
 		return 0;
 	    }
@@ -633,7 +1210,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    
 	    /* Call the student's realloc */
 	    oldp = trace->blocks[index];
-	    if ((newp = mm_realloc(oldp, size)) == NULL) {
+	    if ((newp = alloc->realloc(oldp, size)) == NULL) {
 		malloc_error(tracenum, i, "mm_realloc failed.");
 		return 0;
 	    }
@@ -671,7 +1248,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    /* Remove region from list and call student's free function */
 	    p = trace->blocks[index];
 	    remove_range(ranges, p);
-	    mm_free(p);
+	    alloc->free(p);
 	    break;
 
 	default:
@@ -707,7 +1284,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 
     /* initialize the heap and the mm malloc package */
     mem_reset_brk();
-    if (mm_init() < 0)
+    if (alloc->init() < 0)
 	app_error("mm_init failed in eval_mm_util");
 
     for (i = 0;  i < trace->num_ops;  i++) {
@@ -717,7 +1294,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    index = trace->ops[i].index;
 	    size = trace->ops[i].size;
 
-	    if ((p = mm_malloc(size)) == NULL) 
+	    if ((p = alloc->malloc(size)) == NULL) 
 		app_error("mm_malloc failed in eval_mm_util");
 	    
 	    /* Remember region and size */
@@ -739,7 +1316,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    oldsize = trace->block_sizes[index];
 
 	    oldp = trace->blocks[index];
-	    if ((newp = mm_realloc(oldp,newsize)) == NULL)
+	    if ((newp = alloc->realloc(oldp,newsize)) == NULL)
 		app_error("mm_realloc failed in eval_mm_util");
 
 	    /* Remember region and size */
@@ -760,7 +1337,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    size = trace->block_sizes[index];
 	    p = trace->blocks[index];
 	    
-	    mm_free(p);
+	    alloc->free(p);
 	    
 	    /* Keep track of current total size
 	     * of all allocated blocks */
@@ -778,6 +1355,75 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 }
 
 
+/*
+ * eval_mm_timeline - Replay the trace with the mm package and, every
+ *    timeline_interval requests (and after the last one), append a CSV
+ *    row with the heap size, the bytes in allocated payloads, and the
+ *    number of free blocks and largest free block reported by 
+ *    mm_freeinfo. Each trace's rows are written with a single append 
+ *    so that parallel workers (-j) don't interleave them.
+ */
+static void eval_mm_timeline(trace_t *trace, int tracenum, char *tracefile)
+{
+    int i, index, size;
+    long live = 0;
+    size_t free_blocks, largest_free;
+    char *p, *buf = NULL;
+    size_t buflen = 0;
+    FILE *out;
+
+    if ((out = open_memstream(&buf, &buflen)) == NULL)
+	unix_error("open_memstream failed in eval_mm_timeline");
+
+    mem_reset_brk();
+    if (alloc->init() < 0)
+	app_error("mm_init failed in eval_mm_timeline");
+
+    for (i = 0;  i < trace->num_ops;  i++) {
+	index = trace->ops[i].index;
+	size = trace->ops[i].size;
+	switch (trace->ops[i].type) {
+	case ALLOC:
+	    if ((p = alloc->malloc(size)) == NULL)
+		app_error("mm_malloc failed in eval_mm_timeline");
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    live += size;
+	    break;
+
+	case REALLOC:
+	    if ((p = alloc->realloc(trace->blocks[index], size)) == NULL)
+		app_error("mm_realloc failed in eval_mm_timeline");
+	    live += size - (long)trace->block_sizes[index];
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
+	case FREE:
+	    alloc->free(trace->blocks[index]);
+	    live -= trace->block_sizes[index];
+	    break;
+
+	default:
+	    app_error("Nonexistent request type in eval_mm_timeline");
+	}
+
+	if ((i + 1) % timeline_interval == 0 || i == trace->num_ops - 1) {
+	    free_blocks = largest_free = 0;
+	    if (alloc->freeinfo)
+		alloc->freeinfo(&free_blocks, &largest_free);
+	    fprintf(out, "%d,%s,%d,%lu,%ld,%lu,%lu\n", tracenum, tracefile, 
+		    i + 1, (unsigned long)mem_heapsize(), live, 
+		    (unsigned long)free_blocks, (unsigned long)largest_free);
+	}
+    }
+
+    fclose(out);
+    if (write(timeline_fd, buf, buflen) != (ssize_t)buflen)
+	unix_error("write failed on timeline file");
+    free(buf);
+}
+
 /*
  * eval_mm_speed - This is the function that is used by fcyc()
  *    to measure the running time of the mm malloc package.
@@ -790,7 +1436,7 @@ static void eval_mm_speed(void *ptr)
 
     /* Reset the heap and initialize the mm package */
     mem_reset_brk();
-    if (mm_init() < 0) 
+    if (alloc->init() < 0) 
 	app_error("mm_init failed in eval_mm_speed");
 
     /* Interpret each trace request */
@@ -800,7 +1446,7 @@ static void eval_mm_speed(void *ptr)
         case ALLOC: /* mm_malloc */
             index = trace->ops[i].index;
             size = trace->ops[i].size;
-            if ((p = mm_malloc(size)) == NULL)
+            if ((p = alloc->malloc(size)) == NULL)
 		app_error("mm_malloc error in eval_mm_speed");
             trace->blocks[index] = p;
             break;
@@ -809,7 +1455,7 @@ static void eval_mm_speed(void *ptr)
 	    index = trace->ops[i].index;
             newsize = trace->ops[i].size;
 	    oldp = trace->blocks[index];
-            if ((newp = mm_realloc(oldp,newsize)) == NULL)
+            if ((newp = alloc->realloc(oldp,newsize)) == NULL)
 		app_error("mm_realloc error in eval_mm_speed");
             trace->blocks[index] = newp;
             break;
@@ -817,7 +1463,7 @@ static void eval_mm_speed(void *ptr)
         case FREE: /* mm_free */
             index = trace->ops[i].index;
             block = trace->blocks[index];
-            mm_free(block);
+            alloc->free(block);
             break;
 
 	default:
@@ -836,11 +1482,15 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
     int i, newsize;
     char *p, *newp, *oldp;
 
+    if (alloc->init() < 0) {
+	malloc_error(tracenum, 0, "init failed.");
+	return 0;
+    }
     for (i = 0;  i < trace->num_ops;  i++) {
         switch (trace->ops[i].type) {
 
         case ALLOC: /* malloc */
-	    if ((p = malloc(trace->ops[i].size)) == NULL) {
+	    if ((p = alloc->malloc(trace->ops[i].size)) == NULL) {
 		malloc_error(tracenum, i, "libc malloc failed");
 		unix_error("System message");
 	    }
@@ -850,7 +1500,7 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 	case REALLOC: /* realloc */
             newsize = trace->ops[i].size;
 	    oldp = trace->blocks[trace->ops[i].index];
-	    if ((newp = realloc(oldp, newsize)) == NULL) {
+	    if ((newp = alloc->realloc(oldp, newsize)) == NULL) {
 		malloc_error(tracenum, i, "libc realloc failed");
 		unix_error("System message");
 	    }
@@ -858,7 +1508,7 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 	    break;
 	    
         case FREE: /* free */
-	    free(trace->blocks[trace->ops[i].index]);
+	    alloc->free(trace->blocks[trace->ops[i].index]);
 	    break;
 
 	default:
@@ -881,12 +1531,14 @@ static void eval_libc_speed(void *ptr)
     char *p, *newp, *oldp, *block;
     trace_t *trace = ((speed_t *)ptr)->trace;
 
+    if (alloc->init() < 0)
+	app_error("init failed in eval_libc_speed");
     for (i = 0;  i < trace->num_ops;  i++) {
         switch (trace->ops[i].type) {
         case ALLOC: /* malloc */
 	    index = trace->ops[i].index;
 	    size = trace->ops[i].size;
-	    if ((p = malloc(size)) == NULL)
+	    if ((p = alloc->malloc(size)) == NULL)
 		unix_error("malloc failed in eval_libc_speed");
 	    trace->blocks[index] = p;
 	    break;
@@ -895,7 +1547,7 @@ static void eval_libc_speed(void *ptr)
 	    index = trace->ops[i].index;
 	    newsize = trace->ops[i].size;
 	    oldp = trace->blocks[index];
-	    if ((newp = realloc(oldp, newsize)) == NULL)
+	    if ((newp = alloc->realloc(oldp, newsize)) == NULL)
 		unix_error("realloc failed in eval_libc_speed\n");
 	    
 	    trace->blocks[index] = newp;
@@ -904,87 +1556,1362 @@ static void eval_libc_speed(void *ptr)
         case FREE: /* free */
 	    index = trace->ops[i].index;
 	    block = trace->blocks[index];
-	    free(block);
+	    alloc->free(block);
 	    break;
 	}
     }
 }
 
-/*************************************
- * Some miscellaneous helper routines
- ************************************/
-
-
 /*
- * printresults - prints a performance summary for some malloc package
+ * eval_access - Return the running time of one replay of a trace that
+ *    also accesses the payloads (see eval_access_speed)
  */
-static void printresults(int n, stats_t *stats) 
+static double eval_access(speed_t *params)
 {
-    int i;
-    double secs = 0;
-    double ops = 0;
-    double util = 0;
-
-    /* Print the individual results for each trace */
-    printf("%5s%7s %5s%8s%10s%6s\n", 
-	   "trace", " valid", "util", "ops", "secs", "Kops");
-    for (i=0; i < n; i++) {
-	if (stats[i].valid) {
-	    printf("%2d%10s%5.0f%%%8.0f%10.6f%6.0f\n", 
-		   i,
-		   "yes",
-		   stats[i].util*100.0,
-		   stats[i].ops,
-		   stats[i].secs,
-		   (stats[i].ops/1e3)/stats[i].secs);
-	    secs += stats[i].secs;
-	    ops += stats[i].ops;
-	    util += stats[i].util;
-	}
-	else {
-	    printf("%2d%10s%6s%8s%10s%6s\n", 
-		   i,
-		   "no",
-		   "-",
-		   "-",
-		   "-",
-		   "-");
-	}
-    }
-
-    /* Print the aggregate results for the set of traces */
-    if (errors == 0) {
-	printf("%12s%5.0f%%%8.0f%10.6f%6.0f\n", 
-	       "Total       ",
-	       (util/n)*100.0,
-	       ops, 
-	       secs,
-	       (ops/1e3)/secs);
-    }
-    else {
-	printf("%12s%6s%8s%10s%6s\n", 
-	       "Total       ",
-	       "-", 
-	       "-", 
-	       "-", 
-	       "-");
-    }
-
+    trace_t *trace = params->trace;
+    double secs;
+
+    params->order = (int *)malloc((trace->num_ops + 1) * sizeof(int));
+    params->pos = (int *)malloc((trace->num_ids + 1) * sizeof(int));
+    if (params->order == NULL || params->pos == NULL)
+	unix_error("malloc failed in eval_access");
+    secs = fsecs(eval_access_speed, params);
+    free(params->order);
+    free(params->pos);
+    return secs;
 }
 
-/* 
- * app_error - Report an arbitrary application error
+/*
+ * eval_access_speed - Replay a trace like eval_mm_speed, but also act
+ *    like a program that uses its memory: each block is written when 
+ *    it is allocated (and the new part when realloc grows it), and 
+ *    every access_interval requests the next access_frac of the live 
+ *    blocks are read, walking them in the order in which they were 
+ *    allocated. An allocator that places blocks allocated together 
+ *    close together touches fewer cache lines and pages in the walk.
  */
-void app_error(char *msg) 
+static void eval_access_speed(void *ptr)
 {
-    printf("%s\n", msg);
-    exit(1);
-}
+    speed_t *params = (speed_t *)ptr;
+    trace_t *trace = params->trace;
+    int *order = params->order, *pos = params->pos;
+    int norder = 0;   /* used entries of order, some of them freed (-1) */
+    int nlive = 0;    /* live blocks */
+    int cursor = 0;   /* where the next walk starts in order */
+    int i, j, k, index, size, oldsize, nread;
+    unsigned sum = 0;
+    char *p;
 
-/* 
- * unix_error - Report a Unix-style error
- */
-void unix_error(char *msg) 
+    if (alloc->uses_memlib)
+	mem_reset_brk();
+    if (alloc->init() < 0)
+	app_error("init failed in eval_access_speed");
+
+    for (i = 0;  i < trace->num_ops;  i++) {
+	index = trace->ops[i].index;
+	size = trace->ops[i].size;
+	switch (trace->ops[i].type) {
+
+	case ALLOC:
+	    if ((p = alloc->malloc(size)) == NULL)
+		app_error("malloc failed in eval_access_speed");
+	    memset(p, index, size);
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    order[norder] = index;
+	    pos[index] = norder++;
+	    nlive++;
+	    break;
+
+	case REALLOC: /* the block keeps its place in the walk */
+	    oldsize = trace->block_sizes[index];
+	    if ((p = alloc->realloc(trace->blocks[index], size)) == NULL)
+		app_error("realloc failed in eval_access_speed");
+	    if (size > oldsize)
+		memset(p + oldsize, index, size - oldsize);
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
+	case FREE:
+	    alloc->free(trace->blocks[index]);
+	    order[pos[index]] = -1;
+	    nlive--;
+	    break;
+
+	default:
+	    app_error("Nonexistent request type in eval_access_speed");
+	}
+
+	if ((i + 1) % access_interval != 0 || nlive == 0)
+	    continue;
+
+	/* Squeeze out the freed blocks once they are the majority */
+	if (norder > 2 * nlive) {
+	    for (j = k = 0; j < norder; j++) {
+		if (j == cursor)
+		    cursor = k;
+		if (order[j] >= 0) {
+		    order[k] = order[j];
+		    pos[order[k]] = k;
+		    k++;
+		}
+	    }
+	    norder = k;
+	}
+
+	/* Read the next nread live blocks, one word per cache line */
+	nread = (int)(access_frac * nlive + 0.5);
+	if (nread < 1)
+	    nread = 1;
+	while (nread > 0) {
+	    if (cursor >= norder)
+		cursor = 0;
+	    if ((index = order[cursor++]) < 0)
+		continue;
+	    p = trace->blocks[index];
+	    size = trace->block_sizes[index];
+	    for (j = 0; j < size; j += ACCESS_LINE)
+		sum += (unsigned char)p[j];
+	    nread--;
+	}
+    }
+    access_sink = sum;
+}
+
+/*
+ * get_faults - Return the minor and major page faults the process has
+ *    taken so far
+ */
+static void get_faults(double *minflt, double *majflt)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) < 0)
+	unix_error("getrusage failed in get_faults");
+    *minflt = usage.ru_minflt;
+    *majflt = usage.ru_majflt;
+}
+
+/*
+ * now_ns - Return a timestamp in nanoseconds 
+ */
+static unsigned long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * eval_latency - Replay the trace LATENCY_RUNS times, timestamping 
+ *    each individual request, and record the latency quantiles of 
+ *    each type of request in stats. The cost of reading the clock is 
+ *    measured once and subtracted from every sample.
+ */
+static void eval_latency(trace_t *trace, stats_t *stats)
+{
+    static hist_t hists[NUM_OPTYPES];
+    static long long ovhd = -1;
+    unsigned long long start, lat;
+    int i, run, type, index, size;
+    char *p;
+
+    /* Estimate the overhead of a pair of back-to-back timestamps */
+    if (ovhd < 0) {
+	ovhd = 1LL << 62;
+	for (i = 0; i < 1000; i++) {
+	    start = now_ns();
+	    lat = now_ns() - start;
+	    if ((long long)lat < ovhd)
+		ovhd = lat;
+	}
+    }
+
+    for (type = 0; type < NUM_OPTYPES; type++)
+	hist_reset(&hists[type]);
+
+    for (run = 0; run < LATENCY_RUNS; run++) {
+	if (alloc->uses_memlib)
+	    mem_reset_brk();
+	if (alloc->init() < 0)
+	    app_error("init failed in eval_latency");
+	for (i = 0;  i < trace->num_ops;  i++) {
+	    type = trace->ops[i].type;
+	    index = trace->ops[i].index;
+	    size = trace->ops[i].size;
+	    switch (type) {
+	    case ALLOC:
+		start = now_ns();
+		p = alloc->malloc(size);
+		lat = now_ns() - start;
+		if (p == NULL)
+		    app_error("malloc failed in eval_latency");
+		trace->blocks[index] = p;
+		break;
+
+	    case REALLOC:
+		start = now_ns();
+		p = alloc->realloc(trace->blocks[index], size);
+		lat = now_ns() - start;
+		if (p == NULL)
+		    app_error("realloc failed in eval_latency");
+		trace->blocks[index] = p;
+		break;
+
+	    case FREE:
+		start = now_ns();
+		alloc->free(trace->blocks[index]);
+		lat = now_ns() - start;
+		break;
+
+	    default:
+		app_error("Nonexistent request type in eval_latency");
+		return;
+	    }
+	    hist_add(&hists[type], 
+		     (long long)lat > ovhd ? lat - ovhd : 0);
+	}
+    }
+
+    for (type = 0; type < NUM_OPTYPES; type++)
+	for (i = 0; i < NUM_QUANTILES; i++)
+	    stats->lat[type][i] = hist_quantile(&hists[type], 
+						lat_quantiles[i]);
+}
+
+/**********************************************************************
+ * The following functions run the complete evaluation of a trace, 
+ * either one trace after another or spread across worker processes.
+ **********************************************************************/
+
+/*
+ * eval_libc_trace - Check libc malloc for correctness on a trace and
+ *    measure its speed 
+ */
+static void eval_libc_trace(char *tracefile, int tracenum, stats_t *stats)
+{
+    trace_t *trace;
+    speed_t speed_params;
+    double minflt, majflt;  /* faults before the replay that is counted */
+
+    trace = read_trace(tracedir, tracefile);
+    stats->ops = trace->num_ops;
+    if (verbose > 1)
+	printf("Checking libc malloc for correctness, ");
+    stats->valid = eval_libc_valid(trace, tracenum);
+    if (stats->valid) {
+	speed_params.trace = trace;
+	if (verbose > 1)
+	    printf("and performance.\n");
+	stats->secs = eval_speed(eval_libc_speed, &speed_params, stats);
+	if (measure_vm) {
+	    /* libc's heap isn't ours to release or inspect */
+	    get_faults(&minflt, &majflt);
+	    eval_libc_speed(&speed_params);
+	    get_faults(&stats->minflt, &stats->majflt);
+	    stats->minflt -= minflt;
+	    stats->majflt -= majflt;
+	    stats->pages = -1;
+	}
+	if (measure_cold)
+	    stats->cold_secs = eval_cold(eval_libc_speed, &speed_params);
+	if (access_interval)
+	    stats->access_secs = eval_access(&speed_params);
+	if (measure_perf)
+	    eval_perf(eval_libc_speed, &speed_params, stats);
+	if (measure_latency)
+	    eval_latency(trace, stats);
+    }
+    free_trace(trace);
+}
+
+/*
+ * eval_mm_trace - Check the mm package for correctness on a trace and 
+ *    measure its space utilization and speed
+ */
+static void eval_mm_trace(char *tracefile, int tracenum, stats_t *stats)
+{
+    trace_t *trace;
+    range_t *ranges = NULL;
+    speed_t speed_params;
+    double minflt, majflt;  /* faults before the replay that is counted */
+
+    trace = read_trace(tracedir, tracefile);
+    stats->ops = trace->num_ops;
+    if (verbose > 1)
+	printf("Checking mm_malloc for correctness, ");
+    stats->valid = eval_mm_valid(trace, tracenum, &ranges);
+    if (stats->valid) {
+	if (verbose > 1)
+	    printf("efficiency, ");
+	/* Replay from an empty resident set to see which pages mm touches */
+	if (score_weights[SCORE_RSS] > 0 || measure_vm)
+	    mem_release();
+	get_faults(&minflt, &majflt);
+	stats->util = eval_mm_util(trace, tracenum, &ranges);
+	if (measure_vm) {
+	    get_faults(&stats->minflt, &stats->majflt);
+	    stats->minflt -= minflt;
+	    stats->majflt -= majflt;
+	    stats->pages = mem_resident() / mem_pagesize();
+	}
+	if (score_weights[SCORE_RSS] > 0)
+	    stats->rss_util = mem_resident() ? 
+		stats->util * mem_heapsize() / mem_resident() : 1.0;
+	if (timeline_fd >= 0 && alloc == find_allocator("mm"))
+	    eval_mm_timeline(trace, tracenum, tracefile);
+	speed_params.trace = trace;
+	speed_params.ranges = ranges;
+	if (verbose > 1)
+	    printf("and performance.\n");
+	stats->secs = eval_speed(eval_mm_speed, &speed_params, stats);
+	if (measure_cold)
+	    stats->cold_secs = eval_cold(eval_mm_speed, &speed_params);
+	if (access_interval)
+	    stats->access_secs = eval_access(&speed_params);
+	if (measure_perf)
+	    eval_perf(eval_mm_speed, &speed_params, stats);
+	if (measure_latency)
+	    eval_latency(trace, stats);
+    }
+    clear_ranges(&ranges);
+    free_trace(trace);
+}
+
+/*
+ * eval_speed - Return the running time of one replay of a trace by f.
+ *    Normally this is fsecs's estimate. In benchmark mode (-B) the 
+ *    trace is replayed bench_warmup times untimed and then timed 
+ *    bench_samples times (each sample repeating a short replay until
+ *    it is well above the timer's resolution); the raw samples and 
+ *    their robust summary are kept in stats and the median is returned.
+ */
+static double eval_speed(fsecs_test_funct f, void *argp, stats_t *stats)
+{
+    double vals[MAX_BENCH_SAMPLES];
+
+    if (bench_samples == 0)
+	return fsecs(f, argp);
+
+    fstats_sample(f, argp, bench_warmup, stats->samples, bench_samples);
+    memcpy(vals, stats->samples, bench_samples * sizeof(double));
+    fstats_summarize(vals, bench_samples, &stats->bench);
+    return stats->bench.median;
+}
+
+/*
+ * eval_cold - Return the median running time of COLD_RUNS replays of a
+ *    trace by f, each timed once right after flushing the caches. A
+ *    replay that is short next to the timer's resolution is flushed 
+ *    and timed again, up to COLD_MAX_REPS times, and the sample is the
+ *    average of these. Unlike fsecs, which repeats the replay and so measures it with 
+ *    the trace and the heap already cached, this shows the cost of 
+ *    an allocator that is called after the program has been busy 
+ *    with other data.
+ */
+static double eval_cold(fsecs_test_funct f, void *argp)
+{
+    double vals[COLD_RUNS], secs;
+    double min_secs = COLD_MIN_TICKS * fsecs_resolution();
+    fstats_t s;
+    int i, reps;
+
+    for (i = 0; i < COLD_RUNS; i++) {
+	secs = 0;
+	reps = 0;
+	do {
+	    fcache_flush();
+	    secs += fsecs_once(f, argp);
+	    reps++;
+	} while (secs < min_secs && reps < COLD_MAX_REPS);
+	vals[i] = secs / reps;
+    }
+    fstats_summarize(vals, COLD_RUNS, &s);
+    return s.median;
+}
+
+/*
+ * eval_perf - Count hardware events over PERF_RUNS replays of a trace 
+ *    by f, and record the number of each event per request in stats
+ */
+static void eval_perf(fsecs_test_funct f, void *argp, stats_t *stats)
+{
+    int i;
+
+    fperf(f, argp, PERF_RUNS, stats->perf);
+    for (i = 0; i < FPERF_NUM_EVENTS; i++)
+	if (stats->perf[i] >= 0)
+	    stats->perf[i] /= stats->ops;
+}
+
+/*
+ * perf_index - Compute the performance index, between 0 and 1, as the 
+ *    weighted sum of these components, each between 0 and 1:
+ *
+ *    util: average space utilization of the traces
+ *    thru: throughput over all traces, relative to ref_thru
+ *    lat:  libc's p99 latency divided by mm's, averaged over the
+ *          request types of each trace
+ *    rss:  average of peak live bytes over resident heap bytes, which
+ *          unlike util doesn't charge for heap pages mm never touches
+ *
+ *    Stores the weighted value of each component in parts.
+ */
+static double perf_index(int n, stats_t *mm_stats, stats_t *libc_stats, 
+			 double ref_thru, double *parts)
+{
+    int i, type, nlat = 0;
+    double secs = 0, ops = 0, util = 0, lat = 0, rss = 0;
+    double c[NUM_SCORES], total = 0;
+
+    for (i = 0; i < n; i++) {
+	secs += mm_stats[i].secs;
+	ops += mm_stats[i].ops;
+	util += mm_stats[i].util;
+	rss += (mm_stats[i].rss_util < 1.0) ? mm_stats[i].rss_util : 1.0;
+	if (score_weights[SCORE_LAT] == 0 || !libc_stats[i].valid)
+	    continue;
+	for (type = 0; type < NUM_OPTYPES; type++) {
+	    double mm_p99 = mm_stats[i].lat[type][1];
+	    double libc_p99 = libc_stats[i].lat[type][1];
+
+	    if (mm_p99 > 0 && libc_p99 > 0) {
+		lat += (libc_p99 < mm_p99) ? libc_p99 / mm_p99 : 1.0;
+		nlat++;
+	    }
+	}
+    }
+
+    c[SCORE_UTIL] = util / n;
+    c[SCORE_THRU] = (ops/secs > ref_thru) ? 1.0 : (ops/secs) / ref_thru;
+    c[SCORE_LAT] = nlat ? lat / nlat : 1.0;
+    c[SCORE_RSS] = rss / n;
+    for (i = 0; i < NUM_SCORES; i++) {
+	parts[i] = score_weights[i] * c[i];
+	total += parts[i];
+    }
+    return total;
+}
+
+/*
+ * parse_weights - Set the weights of the performance index components 
+ *    from a spec such as "util=0.5,thru=0.3,lat=0.2". Components that 
+ *    aren't named get no weight, and the weights are scaled to sum to 
+ *    1. Returns 0 if the spec is malformed.
+ */
+static int parse_weights(char *spec)
+{
+    double w[NUM_SCORES] = {0}, sum = 0;
+    char *buf, *tok, *save, *eq, *end;
+    int i, ok = 1;
+
+    if ((buf = strdup(spec)) == NULL)
+	unix_error("strdup failed in parse_weights");
+    for (tok = strtok_r(buf, ",", &save); tok && ok; 
+	 tok = strtok_r(NULL, ",", &save)) {
+	ok = 0;
+	if ((eq = strchr(tok, '=')) == NULL)
+	    break;
+	*eq = '\0';
+	for (i = 0; i < NUM_SCORES; i++) {
+	    if (!strcmp(tok, score_names[i])) {
+		w[i] = strtod(eq + 1, &end);
+		ok = (*end == '\0' && end != eq + 1 && w[i] >= 0);
+	    }
+	}
+    }
+    free(buf);
+    for (i = 0; i < NUM_SCORES; i++)
+	sum += w[i];
+    if (!ok || sum <= 0) {
+	fprintf(stderr, "Bad weights \"%s\"\n", spec);
+	return 0;
+    }
+    for (i = 0; i < NUM_SCORES; i++)
+	score_weights[i] = w[i] / sum;
+    return 1;
+}
+
+/*
+ * eval_traces - Evaluate each trace in turn, or in num_jobs worker 
+ *    processes if -j was given
+ */
+static void eval_traces(eval_trace_funct eval, char **tracefiles, 
+			int num_tracefiles, stats_t *stats)
+{
+    int i;
+
+    if (num_jobs > 1 && num_tracefiles > 1) {
+	eval_traces_parallel(eval, tracefiles, num_tracefiles, stats);
+	return;
+    }
+    for (i=0; i < num_tracefiles; i++)
+	eval(tracefiles[i], i, &stats[i]);
+}
+
+/*
+ * eval_traces_parallel - Evaluate the traces in num_jobs worker 
+ *    processes. Each worker is a fork of the driver, so it has its own 
+ *    copy of the memlib heap and of the mm package's globals. Workers 
+ *    claim the next unevaluated trace from a counter in shared memory 
+ *    and send a result_t for it back over a pipe, which the parent 
+ *    merges into the stats array.
+ */
+static void eval_traces_parallel(eval_trace_funct eval, char **tracefiles, 
+				 int num_tracefiles, stats_t *stats)
+{
+    int i, j, n, status;
+    int fds[2];
+    int njobs = (num_jobs < num_tracefiles) ? num_jobs : num_tracefiles;
+    int *done;             /* which traces have reported results */
+    int *next;             /* next unclaimed trace (shared) */
+    pid_t *pids;
+    result_t result;
+
+    if ((next = mmap(NULL, sizeof(int), PROT_READ | PROT_WRITE, 
+		     MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+	unix_error("mmap failed in eval_traces_parallel");
+    *next = 0;
+    if ((done = (int *)calloc(num_tracefiles, sizeof(int))) == NULL)
+	unix_error("calloc failed in eval_traces_parallel");
+    if ((pids = (pid_t *)malloc(njobs * sizeof(pid_t))) == NULL)
+	unix_error("malloc failed in eval_traces_parallel");
+    if (pipe(fds) < 0)
+	unix_error("pipe failed in eval_traces_parallel");
+
+    /* Don't let the workers inherit (and reprint) our buffered output */
+    fflush(stdout);
+
+    for (j = 0; j < njobs; j++) {
+	if ((pids[j] = fork()) < 0)
+	    unix_error("fork failed in eval_traces_parallel");
+	if (pids[j] == 0) {
+	    /* Worker: evaluate traces until none are left */
+	    close(fds[0]);
+	    if (pin_cpu >= 0)
+		topo_pin_cpu((pin_cpu + j) % topo_num_cpus());
+	    while ((i = __sync_fetch_and_add(next, 1)) < num_tracefiles) {
+		int errors_before = errors;
+
+		memset(&result, 0, sizeof(result));
+		result.tracenum = i;
+		eval(tracefiles[i], i, &result.stats);
+		result.errors = errors - errors_before;
+		fflush(stdout);
+		/* Records are smaller than PIPE_BUF, so writes are atomic */
+		if (write(fds[1], &result, sizeof(result)) != sizeof(result))
+		    unix_error("write failed in eval_traces_parallel");
+	    }
+	    fflush(stdout);
+	    _exit(0);
+	}
+    }
+
+    /* Parent: merge results as they arrive */
+    close(fds[1]);
+    while ((n = read(fds[0], &result, sizeof(result))) == sizeof(result)) {
+	stats[result.tracenum] = result.stats;
+	done[result.tracenum] = 1;
+	errors += result.errors;
+    }
+    if (n != 0)
+	unix_error("read failed in eval_traces_parallel");
+    close(fds[0]);
+
+    for (j = 0; j < njobs; j++) {
+	if (waitpid(pids[j], &status, 0) < 0)
+	    unix_error("waitpid failed in eval_traces_parallel");
+	if (WIFSIGNALED(status))
+	    printf("ERROR: worker process %d terminated by signal %d\n",
+		   (int)pids[j], WTERMSIG(status));
+    }
+
+    /* Any trace without a result crashed the worker that ran it */
+    for (i = 0; i < num_tracefiles; i++) {
+	if (!done[i]) {
+	    stats[i].valid = 0;
+	    malloc_error(i, 0, "worker process died while running trace");
+	}
+    }
+
+    munmap(next, sizeof(int));
+    free(done);
+    free(pids);
+}
+
+
+/*
+ * numa_sweep - Measure the throughput of mm on all of the traces with
+ *    the driver running on each NUMA node that has CPUs and the heap 
+ *    on each node that has memory, and print it as a matrix along 
+ *    with the slowdown relative to the node-local heap. The traces 
+ *    are run one at a time, since -j workers would land on other 
+ *    CPUs. The -p and -n placement is restored afterwards.
+ */
+static void numa_sweep(char **tracefiles, int num_tracefiles)
+{
+    int cpu_nodes[TOPO_MAX_NODES], mem_nodes[TOPO_MAX_NODES];
+    int ncpu, nmem, c, m, i, cpu;
+    int saved_jobs = num_jobs, saved_fd = timeline_fd;
+    double secs, ops, local, kops[TOPO_MAX_NODES];
+    stats_t *stats;
+
+    if ((stats = (stats_t *)calloc(num_tracefiles, sizeof(stats_t))) == NULL)
+	unix_error("calloc failed in numa_sweep");
+    ncpu = topo_cpu_nodes(cpu_nodes, TOPO_MAX_NODES);
+    nmem = topo_mem_nodes(mem_nodes, TOPO_MAX_NODES);
+    num_jobs = 1;
+    timeline_fd = -1;
+    alloc = find_allocator("mm");
+
+    printf("NUMA placement of the mm heap (Kops, slowdown vs. local):\n");
+    printf("%8s", "cpu\\mem");
+    for (m = 0; m < nmem; m++)
+	printf("%16d", mem_nodes[m]);
+    printf("\n");
+    for (c = 0; c < ncpu; c++) {
+	cpu = topo_node_cpu(cpu_nodes[c]);
+	if (cpu < 0 || topo_pin_cpu(cpu) < 0)
+	    continue;
+	local = 0;
+	for (m = 0; m < nmem; m++) {
+	    kops[m] = 0;
+	    if (mem_bind_node(mem_nodes[m]) < 0)
+		continue;
+	    memset(stats, 0, num_tracefiles * sizeof(stats_t));
+	    eval_traces(eval_mm_trace, tracefiles, num_tracefiles, stats);
+	    secs = ops = 0;
+	    for (i = 0; i < num_tracefiles; i++) {
+		if (stats[i].valid) {
+		    secs += stats[i].secs;
+		    ops += stats[i].ops;
+		}
+	    }
+	    kops[m] = secs > 0 ? (ops/1e3)/secs : 0;
+	    if (mem_nodes[m] == cpu_nodes[c])
+		local = kops[m];
+	}
+	printf("%8d", cpu_nodes[c]);
+	for (m = 0; m < nmem; m++) {
+	    if (kops[m] == 0)
+		printf("%16s", "-");
+	    else if (local > 0)
+		printf("%9.0f (%4.2fx)", kops[m], local / kops[m]);
+	    else
+		printf("%16.0f", kops[m]);
+	}
+	printf("\n");
+    }
+    printf("\n");
+
+    topo_pin_cpu(pin_cpu);
+    mem_bind_node(mem_node);
+    num_jobs = saved_jobs;
+    timeline_fd = saved_fd;
+    free(stats);
+}
+
+
+/*************************************
+ * Some miscellaneous helper routines
+ ************************************/
+
+
+/*
+ * printresults - prints a performance summary for some malloc package
+ */
+static void printresults(int n, stats_t *stats) 
+{
+    int i, e;
+    double secs = 0;
+    double ops = 0;
+    double util = 0;
+    double pages = 0, minflt = 0, majflt = 0;  /* pages is -1 if unknown */
+    double perf[FPERF_NUM_EVENTS] = {0};  /* total events, or -1 */
+    double nounits[FPERF_NUM_EVENTS];
+
+    for (e = 0; e < FPERF_NUM_EVENTS; e++)
+	nounits[e] = -1;
+
+    /* Print the individual results for each trace */
+    printf("%5s%7s %5s", "trace", " valid", "util");
+    if (measure_vm)
+	printf("%7s%8s%7s", "pages", "minflt", "majflt");
+    printf("%8s%10s%6s", "ops", "secs", "Kops");
+    if (measure_perf)
+	for (e = 0; e < FPERF_NUM_EVENTS; e++)
+	    printf("%5s/op", fperf_event_names[e]);
+    printf("\n");
+    for (i=0; i < n; i++) {
+	if (stats[i].valid) {
+	    printf("%2d%10s%5.0f%%", i, "yes", stats[i].util*100.0);
+	    printvm(stats[i].pages, stats[i].minflt, stats[i].majflt);
+	    printf("%8.0f%10.6f%6.0f", 
+		   stats[i].ops,
+		   stats[i].secs,
+		   (stats[i].ops/1e3)/stats[i].secs);
+	    printperf(stats[i].perf);
+	    secs += stats[i].secs;
+	    ops += stats[i].ops;
+	    util += stats[i].util;
+	    if (stats[i].pages < 0 || pages < 0)
+		pages = -1;
+	    else
+		pages += stats[i].pages;
+	    minflt += stats[i].minflt;
+	    majflt += stats[i].majflt;
+	    for (e = 0; e < FPERF_NUM_EVENTS; e++) {
+		if (stats[i].perf[e] < 0 || perf[e] < 0)
+		    perf[e] = -1;
+		else
+		    perf[e] += stats[i].perf[e] * stats[i].ops;
+	    }
+	}
+	else {
+	    printf("%2d%10s%6s", i, "no", "-");
+	    printvm(-1, -1, -1);
+	    printf("%8s%10s%6s", "-", "-", "-");
+	    printperf(nounits);
+	}
+    }
+
+    /* Print the aggregate results for the set of traces */
+    if (errors == 0) {
+	printf("%12s%5.0f%%", "Total       ", (util/n)*100.0);
+	printvm(pages, minflt, majflt);
+	printf("%8.0f%10.6f%6.0f", 
+	       ops, 
+	       secs,
+	       (ops/1e3)/secs);
+	for (e = 0; e < FPERF_NUM_EVENTS; e++)
+	    if (perf[e] >= 0)
+		perf[e] /= ops;
+	printperf(perf);
+    }
+    else {
+	printf("%12s%6s", "Total       ", "-");
+	printvm(-1, -1, -1);
+	printf("%8s%10s%6s", "-", "-", "-");
+	printperf(nounits);
+    }
+
+}
+
+/*
+ * printvm - Print the resident heap pages and page faults of a replay
+ *    (-m) in printresults, or a "-" for those that are unknown
+ */
+static void printvm(double pages, double minflt, double majflt)
+{
+    if (!measure_vm)
+	return;
+    if (pages < 0)
+	printf("%7s", "-");
+    else
+	printf("%7.0f", pages);
+    if (minflt < 0)
+	printf("%8s%7s", "-", "-");
+    else
+	printf("%8.0f%7.0f", minflt, majflt);
+}
+
+/*
+ * printperf - Finish a line of printresults with the hardware events 
+ *    per request (-P), or a "-" for events that weren't counted
+ */
+static void printperf(double *perf)
+{
+    int e;
+
+    if (measure_perf) {
+	for (e = 0; e < FPERF_NUM_EVENTS; e++) {
+	    if (perf[e] < 0)
+		printf("%8s", "-");
+	    else if (e == FPERF_INSTRUCTIONS)
+		printf("%8.0f", perf[e]);
+	    else
+		printf("%8.2f", perf[e]);
+	}
+    }
+    printf("\n");
+}
+
+/*
+ * printlatency - prints the per-request latency quantiles for some 
+ *    malloc package, one row per trace and request type
+ */
+static void printlatency(int n, stats_t *stats)
+{
+    int i, type, q;
+
+    printf("%5s%9s", "trace", "op");
+    for (q = 0; q < NUM_QUANTILES; q++)
+	printf("%9s", lat_names[q]);
+    printf("\n");
+    for (i = 0; i < n; i++) {
+	if (!stats[i].valid) {
+	    printf("%2d%12s", i, "-");
+	    for (q = 0; q < NUM_QUANTILES; q++)
+		printf("%9s", "-");
+	    printf("\n");
+	    continue;
+	}
+	for (type = 0; type < NUM_OPTYPES; type++) {
+	    /* Skip request types that don't appear in the trace */
+	    if (stats[i].lat[type][NUM_QUANTILES-1] == 0)
+		continue;
+	    printf("%2d%12s", i, optype_names[type]);
+	    for (q = 0; q < NUM_QUANTILES; q++)
+		printf("%9.0f", stats[i].lat[type][q]);
+	    printf("\n");
+	}
+    }
+}
+
+/*
+ * printbench - prints the benchmark summary for some malloc package:
+ *    the median replay time with its 95% confidence interval, and the 
+ *    number of samples discarded as outliers
+ */
+static void printbench(int n, stats_t *stats)
+{
+    int i;
+    fstats_t *b;
+
+    printf("%5s%12s%12s%12s%8s%8s\n", 
+	   "trace", "median(us)", "ci_lo(us)", "ci_hi(us)", "+-%", "outl");
+    for (i = 0; i < n; i++) {
+	b = &stats[i].bench;
+	if (!stats[i].valid || b->n == 0) {
+	    printf("%2d%15s%12s%12s%8s%8s\n", i, "-", "-", "-", "-", "-");
+	    continue;
+	}
+	printf("%2d%15.2f%12.2f%12.2f%7.1f%%%5d/%-3d\n", 
+	       i, b->median*1e6, b->ci_lo*1e6, b->ci_hi*1e6,
+	       50.0 * (b->ci_hi - b->ci_lo) / b->median,
+	       b->outliers, b->n + b->outliers);
+    }
+}
+
+/*
+ * printslowdown - prints the throughput of each trace in the usual 
+ *    measurement and in a variant replay whose time is the stats_t 
+ *    member at offset (cold caches for -k, payload access for -x), 
+ *    and how much slower the variant is
+ */
+static void printslowdown(int n, stats_t *stats, char *label, 
+			  size_t offset)
+{
+    int i;
+    double secs = 0, other_secs = 0, ops = 0, other;
+    char heading[32];
+
+#define OTHER_SECS(st) (*(double *)((char *)(st) + offset))
+
+    snprintf(heading, sizeof(heading), "%s Kops", label);
+    printf("%5s%12s%12s%10s\n", "trace", "Kops", heading, "slowdown");
+    for (i = 0; i < n; i++) {
+	if (!stats[i].valid) {
+	    printf("%2d%15s%12s%10s\n", i, "-", "-", "-");
+	    continue;
+	}
+	other = OTHER_SECS(&stats[i]);
+	printf("%2d%15.0f%12.0f%9.2fx\n", i, 
+	       (stats[i].ops/1e3)/stats[i].secs,
+	       (stats[i].ops/1e3)/other,
+	       other/stats[i].secs);
+	secs += stats[i].secs;
+	other_secs += other;
+	ops += stats[i].ops;
+    }
+    if (secs > 0)
+	printf("%-5s%12.0f%12.0f%9.2fx\n", "Total", (ops/1e3)/secs, 
+	       (ops/1e3)/other_secs, other_secs/secs);
+
+#undef OTHER_SECS
+}
+
+/*
+ * printmatrix - prints the utilization and throughput of several 
+ *    malloc packages side by side, one row per trace, followed by 
+ *    their throughput relative to the first package
+ */
+static void printmatrix(int n, int npkgs, allocator_t **pkgs, 
+			stats_t **pkg_stats)
+{
+    int i, k;
+    double secs[MAX_ALLOCATORS+2], ops[MAX_ALLOCATORS+2];
+    double util[MAX_ALLOCATORS+2];
+    int valid[MAX_ALLOCATORS+2];
+    stats_t *st;
+
+    printf("%5s", "trace");
+    for (k = 0; k < npkgs; k++) {
+	printf("%16s", pkgs[k]->name);
+	secs[k] = ops[k] = util[k] = 0;
+	valid[k] = 1;
+    }
+    printf("\n");
+    for (i = 0; i < n; i++) {
+	printf("%2d   ", i);
+	for (k = 0; k < npkgs; k++) {
+	    st = &pkg_stats[k][i];
+	    if (!st->valid) {
+		printf("%7s%9s", "-", "-");
+		valid[k] = 0;
+		continue;
+	    }
+	    if (pkgs[k]->uses_memlib)
+		printf("%6.0f%%", st->util*100.0);
+	    else
+		printf("%7s", "-");
+	    printf("%9.0f", (st->ops/1e3)/st->secs);
+	    secs[k] += st->secs;
+	    ops[k] += st->ops;
+	    util[k] += st->util;
+	}
+	printf("\n");
+    }
+
+    printf("%-5s", "Total");
+    for (k = 0; k < npkgs; k++) {
+	if (!valid[k])
+	    printf("%7s%9s", "-", "-");
+	else if (pkgs[k]->uses_memlib)
+	    printf("%6.0f%%%9.0f", (util[k]/n)*100.0, (ops[k]/1e3)/secs[k]);
+	else
+	    printf("%7s%9.0f", "-", (ops[k]/1e3)/secs[k]);
+    }
+    printf("\n%-5s", "Speed");
+    for (k = 0; k < npkgs; k++) {
+	if (valid[k] && valid[0])
+	    printf("%15.2fx", (ops[k]/secs[k]) / (ops[0]/secs[0]));
+	else
+	    printf("%16s", "-");
+    }
+    printf("\n");
+}
+
+/*
+ * save_samples - Write the raw benchmark samples of each trace to 
+ *    filename, one line per trace: the trace file name, the number of
+ *    samples, and the samples in seconds
+ */
+static void save_samples(char *filename, char **tracefiles, int n, 
+			 stats_t *stats)
+{
+    FILE *f;
+    int i, j;
+
+    if ((f = fopen(filename, "w")) == NULL)
+	unix_error("Could not open samples file");
+    for (i = 0; i < n; i++) {
+	if (!stats[i].valid)
+	    continue;
+	fprintf(f, "%s %d", tracefiles[i], bench_samples);
+	for (j = 0; j < bench_samples; j++)
+	    fprintf(f, " %.9g", stats[i].samples[j]);
+	fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
+/*
+ * compare_samples - Compare the benchmark samples of each trace with 
+ *    the ones saved in filename by an earlier run (-S), typically of 
+ *    another build of the allocator, and report whether the difference
+ *    in replay time is significant at level BENCH_ALPHA
+ */
+static void compare_samples(char *filename, char **tracefiles, int n, 
+			    stats_t *stats)
+{
+    FILE *f;
+    char name[MAXLINE];
+    double base[MAX_BENCH_SAMPLES], sorted[MAX_BENCH_SAMPLES];
+    double p, change;
+    fstats_t bs;
+    int i, j, nbase, found;
+
+    if ((f = fopen(filename, "r")) == NULL)
+	unix_error("Could not open samples file");
+
+    printf("Comparison with %s (Mann-Whitney U, alpha = %.2f):\n", 
+	   filename, BENCH_ALPHA);
+    printf("%5s%12s%12s%9s%10s%9s\n", 
+	   "trace", "base(us)", "new(us)", "change", "p-value", "result");
+    for (i = 0; i < n; i++) {
+	if (!stats[i].valid)
+	    continue;
+
+	/* Find this trace's line in the samples file */
+	rewind(f);
+	found = 0;
+	while (fscanf(f, "%1023s %d", name, &nbase) == 2) {
+	    if (nbase < 1 || nbase > MAX_BENCH_SAMPLES)
+		app_error("Bad sample count in samples file");
+	    for (j = 0; j < nbase; j++)
+		if (fscanf(f, "%lf", &base[j]) != 1)
+		    app_error("Truncated samples file");
+	    if (!strcmp(name, tracefiles[i])) {
+		found = 1;
+		break;
+	    }
+	}
+	if (!found) {
+	    printf("%2d%15s%12s%9s%10s%9s\n", i, "-", "-", "-", "-", "missing");
+	    continue;
+	}
+
+	memcpy(sorted, base, nbase * sizeof(double));
+	fstats_summarize(sorted, nbase, &bs);
+	p = fstats_compare(base, nbase, stats[i].samples, bench_samples);
+	change = 100.0 * (stats[i].bench.median - bs.median) / bs.median;
+	printf("%2d%15.2f%12.2f%+8.1f%%%10.4f%9s\n", i, 
+	       bs.median*1e6, stats[i].bench.median*1e6, change, p,
+	       (p >= BENCH_ALPHA) ? "same" : (change < 0) ? "faster" : "slower");
+    }
+    fclose(f);
+    printf("\n");
+}
+
+/*
+ * result_fields - Flatten the stats of one trace into named values, 
+ *    the columns of the -o output. Values that weren't measured in 
+ *    this run are NAN. These, and infinite values (e.g. the Kops of 
+ *    a replay too fast for the timer), are written as null in JSON 
+ *    and as empty fields in CSV. Returns the number of fields.
+ */
+static int result_fields(stats_t *stats, field_t *fields)
+{
+    int n = 0, type, q, e;
+    int valid = stats->valid;
+
+#define FIELD(fmt, arg, v) do {					\
+	snprintf(fields[n].name, sizeof(fields[n].name), fmt, arg);	\
+	fields[n++].val = (v);						\
+    } while (0)
+
+    FIELD("%s", "valid", valid);
+    FIELD("%s", "ops", stats->ops);
+    FIELD("%s", "secs", valid ? stats->secs : NAN);
+    FIELD("%s", "kops", valid ? (stats->ops/1e3)/stats->secs : NAN);
+    FIELD("%s", "util", valid ? stats->util : NAN);
+    FIELD("%s", "rss_util", (valid && score_weights[SCORE_RSS] > 0) ? 
+	  stats->rss_util : NAN);
+    for (type = 0; type < NUM_OPTYPES; type++)
+	for (q = 0; q < NUM_QUANTILES; q++) {
+	    snprintf(fields[n].name, sizeof(fields[n].name), "%s_%s_ns",
+		     optype_names[type], lat_names[q]);
+	    fields[n++].val = (valid && measure_latency && 
+			       stats->lat[type][NUM_QUANTILES-1] > 0) ? 
+		stats->lat[type][q] : NAN;
+	}
+    FIELD("%s", "pages", (valid && measure_vm && stats->pages >= 0) ? 
+	  stats->pages : NAN);
+    FIELD("%s", "minflt", (valid && measure_vm) ? stats->minflt : NAN);
+    FIELD("%s", "majflt", (valid && measure_vm) ? stats->majflt : NAN);
+    FIELD("%s", "cold_secs", (valid && measure_cold) ? stats->cold_secs : NAN);
+    FIELD("%s", "access_secs", (valid && access_interval) ? 
+	  stats->access_secs : NAN);
+    valid = valid && bench_samples;
+    FIELD("%s", "bench_median", valid ? stats->bench.median : NAN);
+    FIELD("%s", "bench_ci_lo", valid ? stats->bench.ci_lo : NAN);
+    FIELD("%s", "bench_ci_hi", valid ? stats->bench.ci_hi : NAN);
+    FIELD("%s", "bench_outliers", valid ? stats->bench.outliers : NAN);
+    valid = stats->valid && measure_perf;
+    for (e = 0; e < FPERF_NUM_EVENTS; e++)
+	FIELD("%s_per_op", fperf_event_names[e], 
+	      (valid && stats->perf[e] >= 0) ? stats->perf[e] : NAN);
+
+#undef FIELD
+    assert(n <= MAX_FIELDS);
+    return n;
+}
+
+/*
+ * env_metadata - Describe the machine and the driver settings that 
+ *    produced the results. Returns the number of entries.
+ */
+static int env_metadata(meta_t *meta, double perfindex)
+{
+    int n = 0;
+    time_t now = time(NULL);
+    struct utsname u;
+    FILE *f;
+    char line[MAXLINE], *p;
+
+#define META(k, ...) do {					\
+	meta[n].key = (k);					\
+	snprintf(meta[n++].val, MAXLINE, __VA_ARGS__);		\
+    } while (0)
+
+    strftime(line, sizeof(line), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    META("date", "%s", line);
+    if (uname(&u) == 0) {
+	META("host", "%s", u.nodename);
+	META("os", "%s %s %s", u.sysname, u.release, u.machine);
+    }
+    if ((f = fopen("/proc/cpuinfo", "r")) != NULL) {
+	while (fgets(line, sizeof(line), f) != NULL) {
+	    if (strncmp(line, "model name", 10) == 0 && 
+		(p = strchr(line, ':')) != NULL) {
+		p[strcspn(p, "\n")] = '\0';
+		META("cpu", "%s", p + 2);
+		break;
+	    }
+	}
+	fclose(f);
+    }
+    META("cpus", "%ld", sysconf(_SC_NPROCESSORS_ONLN));
+    META("compiler", "%s", __VERSION__);
+    META("word_bits", "%d", (int)(8 * sizeof(void *)));
+    META("max_heap", "%lu", (unsigned long)mem_max_heapsize());
+    META("timer", "%s", fsecs_timer_name());
+    META("jobs", "%d", num_jobs);
+    META("bench_samples", "%d", bench_samples);
+    META("errors", "%d", errors);
+    META("perfindex", "%.1f", perfindex);
+
+#undef META
+    assert(n <= MAX_META);
+    return n;
+}
+
+/*
+ * json_string - Write s as a JSON string literal
+ */
+static void json_string(FILE *f, char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+	if (*s == '"' || *s == '\\')
+	    fprintf(f, "\\%c", *s);
+	else if ((unsigned char)*s < 0x20)
+	    fprintf(f, "\\u%04x", *s);
+	else
+	    fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/*
+ * write_results - Write the per-trace results of each malloc package 
+ *    that was run, and the environment they were measured in, to 
+ *    filename. A name ending in ".json" gives a JSON object; anything 
+ *    else gives CSV with one row per package and trace, preceded by 
+ *    the metadata as "# key: value" comment lines.
+ */
+static void write_results(char *filename, char **tracefiles, int n, 
+			  int npkgs, allocator_t **pkgs, stats_t **pkg_stats,
+			  double perfindex)
+{
+    FILE *f;
+    meta_t meta[MAX_META];
+    field_t fields[MAX_FIELDS];
+    int json, nmeta, nfields, i, j, k, len;
+
+    len = strlen(filename);
+    json = (len >= 5 && !strcmp(filename + len - 5, ".json"));
+    if ((f = fopen(filename, "w")) == NULL)
+	unix_error("Could not open results file");
+    nmeta = env_metadata(meta, perfindex);
+
+    if (json) {
+	fprintf(f, "{\n  \"meta\": {");
+	for (i = 0; i < nmeta; i++) {
+	    fprintf(f, "%s\n    \"%s\": ", i ? "," : "", meta[i].key);
+	    json_string(f, meta[i].val);
+	}
+	fprintf(f, "\n  },\n  \"results\": {");
+	for (k = 0; k < npkgs; k++) {
+	    fprintf(f, "%s\n    \"%s\": [", k ? "," : "", pkgs[k]->name);
+	    for (i = 0; i < n; i++) {
+		fprintf(f, "%s\n      {\"trace\": %d, \"file\": ", 
+			i ? "," : "", i);
+		json_string(f, tracefiles[i]);
+		nfields = result_fields(&pkg_stats[k][i], fields);
+		for (j = 0; j < nfields; j++) {
+		    fprintf(f, ", \"%s\": ", fields[j].name);
+		    if (!isfinite(fields[j].val))
+			fprintf(f, "null");
+		    else
+			fprintf(f, "%.9g", fields[j].val);
+		}
+		fprintf(f, "}");
+	    }
+	    fprintf(f, "\n    ]");
+	}
+	fprintf(f, "\n  }\n}\n");
+    }
+    else {
+	for (i = 0; i < nmeta; i++)
+	    fprintf(f, "# %s: %s\n", meta[i].key, meta[i].val);
+	nfields = result_fields(&pkg_stats[0][0], fields);
+	fprintf(f, "allocator,trace,file");
+	for (j = 0; j < nfields; j++)
+	    fprintf(f, ",%s", fields[j].name);
+	fprintf(f, "\n");
+	for (k = 0; k < npkgs; k++) {
+	    for (i = 0; i < n; i++) {
+		fprintf(f, "%s,%d,%s", pkgs[k]->name, i, tracefiles[i]);
+		nfields = result_fields(&pkg_stats[k][i], fields);
+		for (j = 0; j < nfields; j++) {
+		    if (!isfinite(fields[j].val))
+			fprintf(f, ",");
+		    else
+			fprintf(f, ",%.9g", fields[j].val);
+		}
+		fprintf(f, "\n");
+	    }
+	}
+    }
+    fclose(f);
+}
+
+/*
+ * compare_baseline - Compare the mm results of each trace with the 
+ *    ones stored in filename, a CSV file written by an earlier run 
+ *    with -o. A trace regresses if it was valid in the baseline and 
+ *    now fails, or if its throughput or utilization dropped by more 
+ *    than threshold percent. Traces that aren't in the baseline are 
+ *    skipped, and an empty throughput or utilization field (one that 
+ *    couldn't be measured) reads as 0, which never regresses. Returns 
+ *    the number of regressions.
+ */
+static int compare_baseline(char *filename, char **tracefiles, int n, 
+			    stats_t *stats, double threshold)
+{
+    FILE *f;
+    char line[4*MAXLINE], *tok, *save;
+    int col_alloc = -1, col_file = -1, col_valid = -1;
+    int col_kops = -1, col_util = -1;
+    int i, col, found, regressed, regressions = 0;
+    int header = 0;
+    int *base_valid;
+    double *base_kops, *base_util, kops, dkops, dutil;
+    double keep = 1.0 - threshold / 100.0;
+
+    if ((f = fopen(filename, "r")) == NULL)
+	unix_error("Could not open baseline file");
+    base_valid = (int *)calloc(n, sizeof(int));
+    base_kops = (double *)calloc(n, sizeof(double));
+    base_util = (double *)calloc(n, sizeof(double));
+    if (!base_valid || !base_kops || !base_util)
+	unix_error("calloc failed in compare_baseline");
+    for (i = 0; i < n; i++)
+	base_valid[i] = -1;   /* not in the baseline */
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+	char *alloc = NULL, *file = NULL;
+	int valid = 0;
+	double bkops = 0, butil = 0;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	if (line[0] == '#' || line[0] == '\0')
+	    continue;
+
+	/* The first row names the columns */
+	if (!header) {
+	    for (col = 0, tok = strtok_r(line, ",", &save); tok; 
+		 col++, tok = strtok_r(NULL, ",", &save)) {
+		if (!strcmp(tok, "allocator")) col_alloc = col;
+		else if (!strcmp(tok, "file")) col_file = col;
+		else if (!strcmp(tok, "valid")) col_valid = col;
+		else if (!strcmp(tok, "kops")) col_kops = col;
+		else if (!strcmp(tok, "util")) col_util = col;
+	    }
+	    if (col_alloc < 0 || col_file < 0 || col_valid < 0 || 
+		col_kops < 0 || col_util < 0) {
+		sprintf(msg, "%s is not a results file written by -o", 
+			filename);
+		app_error(msg);
+	    }
+	    header = 1;
+	    continue;
+	}
+
+	/* Empty fields must keep their column, so don't use strtok */
+	for (col = 0, tok = line; tok; col++) {
+	    char *next = strchr(tok, ',');
+
+	    if (next)
+		*next++ = '\0';
+	    if (col == col_alloc) alloc = tok;
+	    else if (col == col_file) file = tok;
+	    else if (col == col_valid) valid = atoi(tok);
+	    else if (col == col_kops) bkops = atof(tok); /* 0 if empty */
+	    else if (col == col_util) butil = atof(tok);
+	    tok = next;
+	}
+	if (alloc == NULL || file == NULL || strcmp(alloc, "mm"))
+	    continue;
+	for (i = 0; i < n; i++) {
+	    if (!strcmp(file, tracefiles[i])) {
+		base_valid[i] = valid;
+		base_kops[i] = bkops;
+		base_util[i] = butil;
+	    }
+	}
+    }
+    fclose(f);
+
+    printf("Baseline comparison with %s (threshold %.1f%%):\n", 
+	   filename, threshold);
+    printf("%5s%11s%11s%9s%11s%7s%9s\n", "trace", "base Kops", "Kops", 
+	   "change", "base util", "util", "change");
+    for (i = 0, found = 0; i < n; i++) {
+	if (base_valid[i] < 0) {
+	    printf("%2d%12s\n", i, "(not in baseline)");
+	    continue;
+	}
+	found++;
+	if (!base_valid[i]) {
+	    printf("%2d%12s\n", i, "(invalid in baseline)");
+	    continue;
+	}
+	if (!stats[i].valid) {
+	    printf("%2d%12s%38s  REGRESSION\n", i, "-", "(now invalid)");
+	    regressions++;
+	    continue;
+	}
+	kops = (stats[i].ops/1e3)/stats[i].secs;
+	dkops = base_kops[i] > 0 ? 100.0 * (kops / base_kops[i] - 1) : 0;
+	dutil = base_util[i] > 0 ? 
+	    100.0 * (stats[i].util / base_util[i] - 1) : 0;
+	if (fabs(dutil) < 0.05)   /* don't print rounding noise as -0.0 */
+	    dutil = 0;
+	regressed = (kops < keep * base_kops[i] || 
+		     stats[i].util < keep * base_util[i]);
+	printf("%2d%14.0f%11.0f%+8.1f%%%10.0f%%%6.0f%%%+8.1f%%%s\n", 
+	       i, base_kops[i], kops, dkops, base_util[i]*100.0, 
+	       stats[i].util*100.0, dutil, regressed ? "  REGRESSION" : "");
+	regressions += regressed;
+    }
+    if (found == 0)
+	printf("Warning: none of the traces are in the baseline\n");
+    printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+
+    free(base_valid);
+    free(base_kops);
+    free(base_util);
+    return regressions;
+}
+
+/* 
+ * app_error - Report an arbitrary application error
+ */
+void app_error(char *msg) 
+{
+    printf("%s\n", msg);
+    exit(1);
+}
+
+/* 
+ * unix_error - Report a Unix-style error
+ */
+void unix_error(char *msg) 
 {
     printf("%s: %s\n", msg, strerror(errno));
     exit(1);
@@ -1004,14 +2931,48 @@ void malloc_error(int tracenum, int opnum, char *msg)
  */
 static void usage(void) 
 {
-    fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+    int i;
+
+    fprintf(stderr, "Usage: mdriver [-hvValLPM] [-f <file>] [-t <dir>] [-j <n>]\n"
+	    "               [-H <MB>] [-c <timer>] [-B <n> [-W <n>] [-S|-C <file>]]\n"
+	    "               [-T <csv> [-i <n>]] [-o <file>] [-b <csv> [-r <pct>]]\n"
+	    "               [-w <weights>] [-R <ops/sec>] [-A <list>] [-k] [-m]\n"
+	    "               [-p <cpu>] [-n <node>] [-N] [-x <n>[:<frac>]]\n");
     fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-A <list>  Compare mm with these malloc packages (or \"all\"):");
+    for (i = 0; allocators[i].name != NULL; i++)
+	fprintf(stderr, " %s", allocators[i].name);
+    fprintf(stderr, ".\n");
     fprintf(stderr, "\t-a         Don't check the team structure.\n");
+    fprintf(stderr, "\t-b <csv>   Exit with status %d if the results regress from this -o file.\n", REGRESS_STATUS);
+    fprintf(stderr, "\t-B <n>     Benchmark mode: report the median of <n> timed replays.\n");
+    fprintf(stderr, "\t-C <file>  Compare benchmark samples with those saved in <file>.\n");
+    fprintf(stderr, "\t-c <timer> Timing method: %s.\n", fsecs_timer_names());
     fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
     fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
     fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-H <MB>    Set the maximum heap size to <MB> megabytes.\n");
+    fprintf(stderr, "\t-i <n>     Sample the heap timeline every <n> requests.\n");
+    fprintf(stderr, "\t-j <n>     Evaluate traces in <n> parallel processes.\n");
+    fprintf(stderr, "\t-k         Also time replays that start with cold caches.\n");
     fprintf(stderr, "\t-l         Run libc malloc as well.\n");
+    fprintf(stderr, "\t-L         Report latency percentiles of each request type.\n");
+    fprintf(stderr, "\t-M         Measure libc on the traces and use its throughput as the cap.\n");
+    fprintf(stderr, "\t-m         Count page faults and resident heap pages of a replay.\n");
+    fprintf(stderr, "\t-N         Measure mm with its heap on each NUMA node.\n");
+    fprintf(stderr, "\t-n <node>  Put the mm heap on NUMA node <node>.\n");
+    fprintf(stderr, "\t-o <file>  Write the results to <file> as JSON (.json) or CSV.\n");
+    fprintf(stderr, "\t-p <cpu>   Run on CPU <cpu> (and -j workers on the CPUs after it).\n");
+    fprintf(stderr, "\t-P         Count hardware events (instructions, cache misses, ...).\n");
+    fprintf(stderr, "\t-R <ops/s> Throughput cap for the performance index (default %.0f).\n", AVG_LIBC_THRUPUT);
+    fprintf(stderr, "\t-r <pct>   Regression threshold for -b (default %.0f%%).\n", REGRESS_PCT);
+    fprintf(stderr, "\t-S <file>  Save benchmark samples to <file>.\n");
     fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+    fprintf(stderr, "\t-T <csv>   Write a heap timeline of each trace to <csv>.\n");
     fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
     fprintf(stderr, "\t-V         Print additional debug info.\n");
+    fprintf(stderr, "\t-w <spec>  Performance index weights, e.g. util=0.5,thru=0.3,lat=0.1,rss=0.1.\n");
+    fprintf(stderr, "\t-W <n>     Untimed warmup replays in benchmark mode (default %d).\n", BENCH_WARMUP);
+    fprintf(stderr, "\t-x <n>[:<f>] Also time replays that write new blocks and read the next\n"
+	    "\t           <f> (default %.2f) of the live blocks every <n> requests.\n", ACCESS_FRAC);
 }
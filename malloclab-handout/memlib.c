@@ -10,27 +10,45 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <errno.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include "memlib.h"
 #include "config.h"
 
+/* NUMA memory policies for mbind (from <numaif.h>, without -lnuma) */
+#define MPOL_DEFAULT 0
+#define MPOL_BIND    2
+#define MAX_NODES  1024  /* size of the node mask passed to mbind */
+
 /* private variables */
 static char *mem_start_brk;  /* points to first byte of heap */
 static char *mem_brk;        /* points to last byte of heap */
 static char *mem_max_addr;   /* largest legal heap address */ 
+static size_t mem_max_heap = MAX_HEAP; /* size of the reserved region */
 
 /* 
  * mem_init - initialize the memory system model
  */
 void mem_init(void)
 {
-    /* allocate the storage we will use to model the available VM */
-    if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
-	fprintf(stderr, "mem_init_vm: malloc error\n");
+    /* 
+     * Reserve the storage we will use to model the available VM. We
+     * map it directly rather than calling malloc so that the same
+     * memlib can back mm.c when it is itself installed as the
+     * process's malloc (see mmshim.c). Pages are only committed when
+     * the heap actually touches them.
+     */
+    mem_start_brk = (char *)mmap(NULL, mem_max_heap, PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+				 -1, 0);
+    if (mem_start_brk == (char *)MAP_FAILED) {
+	fprintf(stderr, "mem_init_vm: mmap error\n");
 	exit(1);
     }
 
-    mem_max_addr = mem_start_brk + MAX_HEAP;  /* max legal heap address */
+    mem_max_addr = mem_start_brk + mem_max_heap; /* max legal heap address */
     mem_brk = mem_start_brk;                  /* heap is empty initially */
 }
 
@@ -39,7 +57,85 @@ void mem_init(void)
  */
 void mem_deinit(void)
 {
-    free(mem_start_brk);
+    munmap(mem_start_brk, mem_max_heap);
+}
+
+/*
+ * mem_set_max_heap - set the maximum heap size in bytes, overriding
+ *    MAX_HEAP. Must be called before mem_init. Returns -1, leaving the
+ *    size unchanged, if a region that large can't be reserved.
+ */
+int mem_set_max_heap(size_t bytes)
+{
+    void *p = mmap(NULL, bytes, PROT_NONE, 
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (bytes == 0 || p == MAP_FAILED)
+	return -1;
+    munmap(p, bytes);
+    mem_max_heap = bytes;
+    return 0;
+}
+
+/*
+ * mem_release - return all of the heap's pages to the kernel, so that
+ *    the next replay of a trace starts with nothing resident
+ */
+void mem_release(void)
+{
+    madvise(mem_start_brk, mem_max_heap, MADV_DONTNEED);
+}
+
+/*
+ * mem_bind_node - place the heap's pages on NUMA node, or let the
+ *    kernel choose again if node is negative. Pages that are already
+ *    resident are released so that they are faulted in on the new
+ *    node. Returns 0 on success and -1 (with errno set) on failure.
+ */
+int mem_bind_node(int node)
+{
+#ifdef __linux__
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))];
+
+    if (node >= MAX_NODES) {
+	errno = EINVAL;
+	return -1;
+    }
+    mem_release();
+    if (node < 0)
+	return syscall(__NR_mbind, mem_start_brk, mem_max_heap, 
+		       MPOL_DEFAULT, NULL, 0, 0);
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |= 
+	1UL << (node % (8 * sizeof(unsigned long)));
+    return syscall(__NR_mbind, mem_start_brk, mem_max_heap, MPOL_BIND, 
+		   mask, MAX_NODES + 1, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/*
+ * mem_resident - returns the number of bytes of the heap that are
+ *    resident in memory, i.e. the pages that the heap has touched
+ */
+size_t mem_resident(void)
+{
+    size_t pagesize = mem_pagesize();
+    size_t i, npages, resident = 0;
+    unsigned char *vec;
+
+    npages = (mem_brk - mem_start_brk + pagesize - 1) / pagesize;
+    if (npages == 0)
+	return 0;
+    if ((vec = malloc(npages)) == NULL)
+	return 0;
+    if (mincore(mem_start_brk, npages * pagesize, vec) == 0)
+	for (i = 0; i < npages; i++)
+	    resident += vec[i] & 1;
+    free(vec);
+    return resident * pagesize;
 }
 
 /*
@@ -92,6 +188,14 @@ size_t mem_heapsize()
     return (size_t)(mem_brk - mem_start_brk);
 }
 
+/*
+ * mem_max_heapsize() - returns the maximum heap size in bytes
+ */
+size_t mem_max_heapsize()
+{
+    return mem_max_heap;
+}
+
 /*
  * mem_pagesize() - returns the page size of the system
  */
@@ -2,10 +2,15 @@
 
 void mem_init(void);               
 void mem_deinit(void);
+int mem_set_max_heap(size_t bytes);
 void *mem_sbrk(int incr);
 void mem_reset_brk(void); 
+void mem_release(void);
+size_t mem_resident(void);
+int mem_bind_node(int node);
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+size_t mem_max_heapsize(void);
 size_t mem_pagesize(void);
 
@@ -398,6 +398,26 @@ int mm_check(void) {
     return check;
 }
 
+/*
+* mm_freeinfo: reports the number of blocks on the segregated free lists and the size of the largest one
+*/
+void mm_freeinfo(size_t *free_blocks, size_t *largest_free) {
+    void *bp;
+    size_t size;
+    int list;
+
+    *free_blocks = 0;
+    *largest_free = 0;
+    for (list = 0; list < LISTS; list++) {
+        for (bp = access_list(1, list, NULL); bp != NULL; bp = SUCCESSOR(bp)) {
+            size = GET_SIZE(HEADER(bp));
+            (*free_blocks)++;
+            if (size > *largest_free)
+                *largest_free = size;
+        }
+    }
+}
+
 /* mm_malloc package */
 
 /* 
@@ -5,6 +5,15 @@ extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
 
+/* 
+ * Optional introspection hook used by the driver's timeline mode (-T):
+ * report the number of free blocks and the size of the largest one.
+ * It is weak, so a mm.c without it still links, and its address is
+ * then NULL.
+ */
+extern void mm_freeinfo(size_t *free_blocks, size_t *largest_free)
+    __attribute__((weak));
+
 
 /* 
  * Students work in teams of one or two.  Teams enter their team name, 
@@ -0,0 +1,312 @@
+/*
+ * mmshim.c - Installs the mm.c package as the process's malloc
+ *
+ * Built into libmm.so (see the Makefile), this module exports the
+ * standard C allocation interface on top of mm_malloc and mm_free so
+ * that mm.c can be LD_PRELOADed into real programs:
+ *
+ *     unix> LD_PRELOAD=./libmm.so some_program
+ *
+ * The heap is the mmap-reserved region managed by memlib.c, so no
+ * request ever reaches the libc allocator.
+ *
+ * Thread safety: mm.c keeps all of its state in globals, so every
+ * entry point serializes on a single mutex. The mutex is taken
+ * around fork() with pthread_atfork so that the child never inherits
+ * a heap that another thread was halfway through modifying.
+ *
+ * Alignment: mm.c only guarantees ALIGNMENT (8) byte payloads, while
+ * the platform ABI expects malloc to return SHIM_ALIGN byte aligned
+ * blocks. Larger alignments are obtained by over-allocating and
+ * handing out an interior pointer. The word just below such a
+ * pointer is tagged with its offset from the real mm.c payload. The
+ * tag has bit 1 set, which can never happen in an mm.c header since
+ * block sizes are multiples of 8.
+ *
+ * Realloc: mm_realloc is not used, since it doesn't keep the contents
+ * of a block that it moves (mdriver reports this on the realloc
+ * traces). realloc copies the data into a new block itself instead.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+
+#define EXPORT __attribute__((visibility("default")))
+
+/* Alignment of blocks returned by malloc, calloc, and realloc */
+#define SHIM_ALIGN (2 * sizeof(size_t))
+
+/* Block layout shared with mm.c: 8 byte header and footer */
+#define SHIM_WSIZE 8
+#define SHIM_OVERHEAD (2 * SHIM_WSIZE)
+
+/* mem_sbrk takes an int, so mm.c can't grow the heap by more than
+   INT_MAX at once. Leave room for its block overhead and rounding. */
+#define SHIM_MAX_REQUEST ((size_t)INT_MAX - 4096)
+
+/* Tag stored below an interior (over-aligned) pointer */
+#define ALIGN_TAG 0x2
+#define HDR_WORD(p) (*(uint64_t *)((char *)(p) - SHIM_WSIZE))
+#define IS_TAGGED(p) (HDR_WORD(p) & ALIGN_TAG)
+#define TAG_OFFSET(p) (HDR_WORD(p) & ~(uint64_t)0x7)
+
+static pthread_mutex_t shim_lock = PTHREAD_MUTEX_INITIALIZER;
+static int shim_initialized = 0;
+
+/*
+ * shim_init - Create the heap on first use. Called with shim_lock held.
+ */
+static void shim_init(void)
+{
+    mem_init();
+    if (mm_init() < 0)
+	abort();
+    shim_initialized = 1;
+}
+
+/* Fork handlers: hold the lock across fork so the child sees a
+   consistent heap */
+static void shim_prepare(void)
+{
+    pthread_mutex_lock(&shim_lock);
+}
+
+static void shim_release(void)
+{
+    pthread_mutex_unlock(&shim_lock);
+}
+
+/*
+ * shim_constructor - Build the heap and install the fork handlers
+ *     when the library is loaded. pthread_atfork may itself call
+ *     malloc, so it must run without shim_lock held.
+ */
+__attribute__((constructor))
+static void shim_constructor(void)
+{
+    pthread_mutex_lock(&shim_lock);
+    if (!shim_initialized)
+	shim_init();
+    pthread_mutex_unlock(&shim_lock);
+    pthread_atfork(shim_prepare, shim_release, shim_release);
+}
+
+/*
+ * in_heap - Is p a pointer that we handed out?
+ */
+static int in_heap(void *p)
+{
+    return shim_initialized &&
+	(char *)p >= (char *)mem_heap_lo() &&
+	(char *)p <= (char *)mem_heap_hi();
+}
+
+/*
+ * shim_memalign - Allocate size bytes aligned to align (a power of
+ *     two). Called with shim_lock held.
+ */
+static void *shim_memalign(size_t align, size_t size)
+{
+    char *raw, *p;
+    size_t offset;
+
+    if (!shim_initialized)
+	shim_init();
+    if (size == 0)
+	size = 1;
+    if (size > MAX_HEAP || align > SHIM_MAX_REQUEST || 
+	size > SHIM_MAX_REQUEST - align) {
+	errno = ENOMEM;
+	return NULL;
+    }
+
+    if (align <= ALIGNMENT) {
+	if ((p = mm_malloc(size)) == NULL)
+	    errno = ENOMEM;
+	return p;
+    }
+
+    if ((raw = mm_malloc(size + align)) == NULL) {
+	errno = ENOMEM;
+	return NULL;
+    }
+    if (((uintptr_t)raw & (align - 1)) == 0)
+	return raw;
+
+    /* raw is ALIGNMENT aligned, so the offset is at least one word */
+    offset = align - ((uintptr_t)raw & (align - 1));
+    p = raw + offset;
+    HDR_WORD(p) = offset | ALIGN_TAG;
+    return p;
+}
+
+/*
+ * shim_base - Return the mm.c payload that p was carved out of
+ */
+static void *shim_base(void *p)
+{
+    if (IS_TAGGED(p))
+	return (char *)p - TAG_OFFSET(p);
+    return p;
+}
+
+/*
+ * shim_usable - Number of payload bytes available at p
+ */
+static size_t shim_usable(void *p)
+{
+    char *base = shim_base(p);
+    size_t blocksize = HDR_WORD(base) & ~(uint64_t)0x7;
+
+    return blocksize - SHIM_OVERHEAD - ((char *)p - base);
+}
+
+/*
+ * shim_free - Release p. Called with shim_lock held.
+ */
+static void shim_free(void *p)
+{
+    if (p == NULL || !in_heap(p))
+	return;
+    mm_free(shim_base(p));
+}
+
+/************************************
+ * The exported allocation interface
+ ***********************************/
+
+EXPORT void *malloc(size_t size)
+{
+    void *p;
+
+    pthread_mutex_lock(&shim_lock);
+    p = shim_memalign(SHIM_ALIGN, size);
+    pthread_mutex_unlock(&shim_lock);
+    return p;
+}
+
+EXPORT void free(void *ptr)
+{
+    pthread_mutex_lock(&shim_lock);
+    shim_free(ptr);
+    pthread_mutex_unlock(&shim_lock);
+}
+
+EXPORT void *calloc(size_t nmemb, size_t size)
+{
+    void *p;
+
+    if (size != 0 && nmemb > SIZE_MAX / size) {
+	errno = ENOMEM;
+	return NULL;
+    }
+    pthread_mutex_lock(&shim_lock);
+    p = shim_memalign(SHIM_ALIGN, nmemb * size);
+    pthread_mutex_unlock(&shim_lock);
+
+    /* Freed blocks are recycled, so the payload may be dirty */
+    if (p != NULL)
+	memset(p, 0, nmemb * size);
+    return p;
+}
+
+EXPORT void *realloc(void *ptr, size_t size)
+{
+    void *p;
+    size_t oldsize;
+
+    if (ptr == NULL)
+	return malloc(size);
+    if (size == 0) {
+	free(ptr);
+	return NULL;
+    }
+
+    pthread_mutex_lock(&shim_lock);
+    if (!in_heap(ptr)) {
+	pthread_mutex_unlock(&shim_lock);
+	errno = ENOMEM;
+	return NULL;
+    }
+
+    /* Shrinking, or growing into the block's slack, stays in place */
+    oldsize = shim_usable(ptr);
+    if (size <= oldsize) {
+	pthread_mutex_unlock(&shim_lock);
+	return ptr;
+    }
+
+    /* Allocate the new block before freeing the old one, so that on
+       failure ptr is left untouched */
+    if ((p = shim_memalign(SHIM_ALIGN, size)) != NULL) {
+	memcpy(p, ptr, oldsize);
+	shim_free(ptr);
+    }
+    pthread_mutex_unlock(&shim_lock);
+    return p;
+}
+
+EXPORT int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    void *p;
+
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)))
+	return EINVAL;
+    pthread_mutex_lock(&shim_lock);
+    p = shim_memalign(alignment < SHIM_ALIGN ? SHIM_ALIGN : alignment, size);
+    pthread_mutex_unlock(&shim_lock);
+    if (p == NULL)
+	return ENOMEM;
+    *memptr = p;
+    return 0;
+}
+
+EXPORT void *memalign(size_t alignment, size_t size)
+{
+    void *p;
+
+    if (alignment & (alignment - 1)) {
+	errno = EINVAL;
+	return NULL;
+    }
+    pthread_mutex_lock(&shim_lock);
+    p = shim_memalign(alignment < SHIM_ALIGN ? SHIM_ALIGN : alignment, size);
+    pthread_mutex_unlock(&shim_lock);
+    return p;
+}
+
+EXPORT void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+EXPORT void *valloc(size_t size)
+{
+    return memalign(mem_pagesize(), size);
+}
+
+EXPORT void *pvalloc(size_t size)
+{
+    size_t pagesize = mem_pagesize();
+
+    return memalign(pagesize, (size + pagesize - 1) & ~(pagesize - 1));
+}
+
+EXPORT size_t malloc_usable_size(void *ptr)
+{
+    size_t size = 0;
+
+    pthread_mutex_lock(&shim_lock);
+    if (ptr != NULL && in_heap(ptr))
+	size = shim_usable(ptr);
+    pthread_mutex_unlock(&shim_lock);
+    return size;
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+# timeline.py - Summarize and plot the heap timeline written by mdriver -T
+#
+# usage: timeline.py <timeline.csv> [<plot.png>]
+#
+# For every trace, prints the peak heap size, the utilization (live
+# payload bytes / heap size) at the point of peak live bytes, and the
+# lowest utilization seen while at least half of the peak was live,
+# along with the request at which it occurred. That is where
+# fragmentation hurt most during the steady state, as opposed to the
+# teardown at the end of a trace. If a plot file is given and
+# matplotlib is installed, also draws one row of panels per trace:
+# heap size vs. live bytes, the number of free blocks, and the largest
+# free block.
+#
+import csv
+import sys
+from collections import OrderedDict
+
+
+def read_timeline(path):
+    traces = OrderedDict()
+    with open(path) as f:
+        for row in csv.DictReader(f):
+            key = (int(row["trace"]), row["file"])
+            traces.setdefault(key, []).append(
+                {k: int(v) for k, v in row.items() if k != "file"})
+    return OrderedDict(sorted(traces.items()))
+
+
+def util(row):
+    return row["live_bytes"] / row["heap_bytes"] if row["heap_bytes"] else 1.0
+
+
+def summarize(traces):
+    print("%5s %-24s %8s %10s %10s %10s %8s" %
+          ("trace", "file", "samples", "peak heap", "util@peak",
+           "worst util", "at op"))
+    for (num, name), rows in traces.items():
+        peak = max(rows, key=lambda r: r["live_bytes"])
+        steady = [r for r in rows if 2 * r["live_bytes"] >= peak["live_bytes"]]
+        worst = min(steady, key=util)
+        print("%5d %-24s %8d %10d %9.0f%% %9.0f%% %8d" %
+              (num, name, len(rows), max(r["heap_bytes"] for r in rows),
+               util(peak) * 100, util(worst) * 100, worst["op"]))
+
+
+def plot(traces, path):
+    try:
+        import matplotlib
+        matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print("matplotlib not available; skipping %s" % path)
+        return
+
+    n = len(traces)
+    fig, axes = plt.subplots(n, 3, figsize=(15, 3 * n), squeeze=False)
+    for row, ((num, name), rows) in zip(axes, traces.items()):
+        ops = [r["op"] for r in rows]
+        row[0].plot(ops, [r["heap_bytes"] for r in rows], label="heap")
+        row[0].plot(ops, [r["live_bytes"] for r in rows], label="live")
+        row[0].set_title("%d: %s" % (num, name))
+        row[0].legend(loc="upper left")
+        row[1].plot(ops, [r["free_blocks"] for r in rows])
+        row[1].set_title("free blocks")
+        row[2].plot(ops, [r["largest_free"] for r in rows])
+        row[2].set_title("largest free block (bytes)")
+        for ax in row:
+            ax.set_xlabel("request")
+    fig.tight_layout()
+    fig.savefig(path)
+    print("wrote %s" % path)
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.stderr.write("usage: %s <timeline.csv> [<plot.png>]\n" % sys.argv[0])
+        sys.exit(1)
+    traces = read_timeline(sys.argv[1])
+    summarize(traces)
+    if len(sys.argv) == 3:
+        plot(traces, sys.argv[2])
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+/*
+ * topology.c - CPU and NUMA node discovery and CPU pinning
+ *
+ * Nodes and their CPUs are read from /sys/devices/system/node, where
+ * the kernel lists them as ranges such as "0-3,8-11". On a machine
+ * (or kernel) without NUMA the directory is missing and everything
+ * is on node 0.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+#include "topology.h"
+
+#define NODE_DIR "/sys/devices/system/node"
+
+/*
+ * parse_list - Parse a kernel list like "0-3,8" from path, storing at
+ *     most max of its members in vals. Returns the number stored, or
+ *     -1 if path can't be read.
+ */
+static int parse_list(char *path, int *vals, int max)
+{
+    FILE *f;
+    char buf[1024], *p, *end;
+    long lo, hi;
+    int n = 0;
+
+    if ((f = fopen(path, "r")) == NULL)
+	return -1;
+    if (fgets(buf, sizeof(buf), f) == NULL)
+	buf[0] = '\0';
+    fclose(f);
+
+    for (p = buf; *p && *p != '\n' && n < max; p = end) {
+	lo = hi = strtol(p, &end, 10);
+	if (end == p)
+	    break;
+	if (*end == '-')
+	    hi = strtol(end + 1, &end, 10);
+	for (; lo <= hi && n < max; lo++)
+	    vals[n++] = (int)lo;
+	if (*end == ',')
+	    end++;
+    }
+    return n;
+}
+
+int topo_num_cpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (n > 0) ? (int)n : 1;
+}
+
+int topo_pin_cpu(int cpu)
+{
+    static cpu_set_t orig;    /* the CPUs we could run on at first */
+    static int saved = 0;
+    cpu_set_t set;
+
+    if (!saved) {
+	if (sched_getaffinity(0, sizeof(orig), &orig) < 0)
+	    return -1;
+	saved = 1;
+    }
+    if (cpu < 0)
+	return sched_setaffinity(0, sizeof(orig), &orig);
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+}
+
+/* Nodes listed in NODE_DIR/<file>, or just node 0 */
+static int node_list(char *file, int *nodes, int max)
+{
+    char path[256];
+    int n;
+
+    sprintf(path, "%s/%s", NODE_DIR, file);
+    if ((n = parse_list(path, nodes, max)) <= 0) {
+	nodes[0] = 0;
+	n = 1;
+    }
+    return n;
+}
+
+int topo_mem_nodes(int *nodes, int max)
+{
+    return node_list("has_memory", nodes, max);
+}
+
+int topo_cpu_nodes(int *nodes, int max)
+{
+    return node_list("has_cpu", nodes, max);
+}
+
+int topo_node_cpu(int node)
+{
+    char path[256];
+    int cpu;
+
+    sprintf(path, "%s/node%d/cpulist", NODE_DIR, node);
+    if (parse_list(path, &cpu, 1) == 1)
+	return cpu;
+    return (node == 0) ? 0 : -1;
+}
@@ -0,0 +1,30 @@
+/*
+ * topology.h - prototypes for the routines in topology.c that find
+ *     the machine's CPUs and NUMA nodes and pin the process to a CPU
+ */
+#ifndef __TOPOLOGY_H_
+#define __TOPOLOGY_H_
+
+/* Max number of NUMA nodes that are handled */
+#define TOPO_MAX_NODES 64
+
+/* topo_num_cpus - Number of CPUs that are online */
+int topo_num_cpus(void);
+
+/* topo_pin_cpu - Run the calling process only on cpu, or on the CPUs
+   it was originally allowed if cpu is negative. Returns 0 on success
+   and -1 (with errno set) on failure */
+int topo_pin_cpu(int cpu);
+
+/* topo_mem_nodes - Store the NUMA nodes that have memory in nodes
+   (at most max) and return how many there are. Machines without
+   NUMA support report a single node 0. */
+int topo_mem_nodes(int *nodes, int max);
+
+/* topo_cpu_nodes - Same as topo_mem_nodes, for the nodes with CPUs */
+int topo_cpu_nodes(int *nodes, int max);
+
+/* topo_node_cpu - First CPU of node, or -1 if it has none */
+int topo_node_cpu(int node);
+
+#endif /* __TOPOLOGY_H_ */
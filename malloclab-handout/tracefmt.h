@@ -0,0 +1,34 @@
+/*
+ * tracefmt.h - The binary tracefile format written by gentrace -b
+ *     and read by mdriver
+ *
+ * A binary trace holds the same information as a .rep file: the
+ * TRACE_MAGIC string, a tracehdr_t, and then num_ops tracerec_t
+ * records. All fields are 32-bit integers in host byte order. It
+ * exists because parsing text dominates load time for traces with
+ * tens of millions of requests.
+ */
+#ifndef __TRACEFMT_H_
+#define __TRACEFMT_H_
+
+#include <stdint.h>
+
+#define TRACE_MAGIC     "MMTRACE1"
+#define TRACE_MAGIC_LEN 8
+
+/* The four header lines of a .rep file */
+typedef struct {
+    int32_t sugg_heapsize;   /* suggested heap size (unused) */
+    int32_t num_ids;         /* number of alloc/realloc ids */
+    int32_t num_ops;         /* number of requests */
+    int32_t weight;          /* weight for this trace (unused) */
+} tracehdr_t;
+
+/* One request line: type is 'a', 'r', or 'f' (size unused for 'f') */
+typedef struct {
+    int32_t type;
+    int32_t index;
+    int32_t size;
+} tracerec_t;
+
+#endif /* __TRACEFMT_H_ */